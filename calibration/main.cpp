@@ -0,0 +1,382 @@
+#include <array>
+#include <cstdio>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <iterator>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <rectpack2D/auto_tuner.h>
+
+/*
+	Generates src/rectpack2D/auto_tuner_table.h, the rules of tune_finder_settings.
+
+	Packs synthetic inputs of several size distributions and counts
+	with every candidate discard step divisor, with all default orders and with just the one by area.
+	Inputs are classed by their count and the variation of their areas, as tune_finder_settings does,
+	and every class gets the fastest candidate that packs within max_density_loss of the densest candidate
+	on every input of the class - or, if there is none, the candidate with the smallest loss.
+	A class without any input gets the finest search with all orders.
+
+	Prints the table to stdout, or to the file passed with -o,
+	and a summary against discard_step = 1 with all orders to stderr.
+	Timings depend on the machine, so build it in Release.
+*/
+
+using namespace rectpack2D;
+
+using spaces_type = empty_spaces<true>;
+using rect_type = output_rect_t<spaces_type>;
+using area_type = search_area_t<spaces_type, void>;
+
+namespace {
+	constexpr std::size_t count_bounds[] = { 100, 1000 };
+	constexpr double variation_bounds[] = { 1 };
+
+	constexpr std::size_t count_classes = std::size(count_bounds) + 1;
+	constexpr std::size_t variation_classes = std::size(variation_bounds) + 1;
+
+	constexpr int candidate_divisors[] = { 0, 4096, 512, 128, 32 };
+	constexpr std::size_t counts[] = { 10, 30, 60, 150, 400, 800, 1500, 4000 };
+
+	constexpr double max_density_loss = 0.005;
+	constexpr int max_side = 16384;
+
+	struct candidate {
+		int divisor = 0;
+		bool all_orders = true;
+	};
+
+	struct measurement {
+		double milliseconds = 0;
+		area_type bin_area = 0;
+	};
+
+	enum class distribution {
+		UNIFORM,
+		HEAVY_TAILED,
+		NEARLY_EQUAL,
+		STRIPS,
+		FEW_BIG
+	};
+
+	std::vector<rect_type> make_input(const distribution d, const std::size_t count, const unsigned seed) {
+		std::mt19937 rng(seed);
+
+		const auto between = [&rng](const int min, const int max) {
+			return std::uniform_int_distribution<int>(min, max)(rng);
+		};
+
+		std::vector<rect_type> rects;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			rect_type r;
+
+			switch (d) {
+				case distribution::UNIFORM:
+					r.w = between(1, 60);
+					r.h = between(1, 60);
+					break;
+
+				case distribution::HEAVY_TAILED: {
+					const auto u = std::uniform_real_distribution<double>(0.001, 1)(rng);
+					r.w = std::min(400, static_cast<int>(4 / std::pow(u, 0.7)));
+					r.h = std::min(400, std::max(1, static_cast<int>(r.w * std::uniform_real_distribution<double>(0.5, 2)(rng))));
+					break;
+				}
+
+				case distribution::NEARLY_EQUAL:
+					r.w = between(30, 33);
+					r.h = between(30, 33);
+					break;
+
+				case distribution::STRIPS:
+					r.w = between(1, 8);
+					r.h = between(40, 200);
+
+					if (between(0, 1)) {
+						std::swap(r.w, r.h);
+					}
+
+					break;
+
+				case distribution::FEW_BIG:
+					if (between(0, 19) == 0) {
+						r.w = between(100, 300);
+						r.h = between(100, 300);
+					}
+					else {
+						r.w = between(1, 20);
+						r.h = between(1, 20);
+					}
+
+					break;
+			}
+
+			rects.push_back(r);
+		}
+
+		return rects;
+	}
+
+	measurement measure(const std::vector<rect_type>& originals, const int discard_step, const bool all_orders) {
+		const auto input = make_finder_input(
+			max_side,
+			discard_step,
+			[](rect_type&) { return callback_result::CONTINUE_PACKING; },
+			[](rect_type&) { return callback_result::CONTINUE_PACKING; },
+			flipping_option::ENABLED
+		);
+
+		measurement result;
+		std::vector<rect_type> rects;
+		int runs = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		auto elapsed = std::chrono::steady_clock::duration::zero();
+
+		/* Small inputs pack in microseconds, so they are repeated for a stable timing. */
+
+		while (runs == 0 || elapsed < std::chrono::milliseconds(20)) {
+			rects = originals;
+
+			const auto bin = with_default_comparators<spaces_type, area_type>(
+				[&](auto by_area, auto... other_comparators) {
+					if (!all_orders) {
+						return find_best_packing<spaces_type>(rects, input, by_area);
+					}
+
+					return find_best_packing<spaces_type>(rects, input, by_area, other_comparators...);
+				}
+			);
+
+			result.bin_area = area_as<area_type>(bin);
+
+			++runs;
+			elapsed = std::chrono::steady_clock::now() - start;
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(elapsed).count() / runs;
+		return result;
+	}
+
+	template <class T, std::size_t N>
+	std::size_t class_of(const T value, const T (&bounds)[N]) {
+		std::size_t index = 0;
+
+		while (index < N && value >= bounds[index]) {
+			++index;
+		}
+
+		return index;
+	}
+
+	/* The results of all candidates on one input. */
+
+	struct input_results {
+		std::size_t count_class = 0;
+		std::size_t variation_class = 0;
+
+		std::vector<measurement> candidates;
+		measurement baseline;
+		area_type densest = 0;
+	};
+}
+
+int main(const int argc, char** const argv) {
+	std::string output_path;
+
+	if (argc == 3 && std::string(argv[1]) == "-o") {
+		output_path = argv[2];
+	}
+	else if (argc != 1) {
+		std::cerr << "Usage: rectpack2D-calibration [-o <auto_tuner_table.h>]\n";
+		return 2;
+	}
+
+	std::vector<candidate> candidates;
+
+	for (const auto divisor : candidate_divisors) {
+		candidates.push_back({ divisor, true });
+		candidates.push_back({ divisor, false });
+	}
+
+	std::vector<input_results> results;
+
+	const distribution distributions[] = {
+		distribution::UNIFORM,
+		distribution::HEAVY_TAILED,
+		distribution::NEARLY_EQUAL,
+		distribution::STRIPS,
+		distribution::FEW_BIG
+	};
+
+	for (const auto d : distributions) {
+		for (const auto count : counts) {
+			const auto rects = make_input(d, count, static_cast<unsigned>(count) * 31 + static_cast<unsigned>(d));
+			const auto statistics = gather_input_statistics<area_type>(rects);
+
+			input_results r;
+			r.count_class = class_of(statistics.count, count_bounds);
+			r.variation_class = class_of(statistics.area_variation, variation_bounds);
+
+			for (const auto& c : candidates) {
+				r.candidates.push_back(measure(rects, tuned_discard_step(statistics, c.divisor), c.all_orders));
+			}
+
+			r.baseline = measure(rects, 1, true);
+			r.densest = r.baseline.bin_area;
+
+			for (const auto& m : r.candidates) {
+				r.densest = std::min(r.densest, m.bin_area);
+			}
+
+			std::cerr << "Distribution " << int(d) << ", " << count << " rectangles: variation " << statistics.area_variation << "\n";
+			results.push_back(r);
+		}
+	}
+
+	const auto loss = [](const measurement& m, const input_results& r) {
+		return static_cast<double>(m.bin_area) / static_cast<double>(r.densest) - 1;
+	};
+
+	/* Default-constructed candidates are the finest search with all orders. */
+
+	std::array<std::array<candidate, variation_classes>, count_classes> table;
+
+	for (std::size_t c = 0; c < count_classes; ++c) {
+		for (std::size_t v = 0; v < variation_classes; ++v) {
+			double best_loss = 0;
+			double best_time = 0;
+			bool found = false;
+
+			for (std::size_t k = 0; k < candidates.size(); ++k) {
+				bool any_input = false;
+				double worst_loss = 0;
+				double relative_time = 0;
+
+				for (const auto& r : results) {
+					if (r.count_class != c || r.variation_class != v) {
+						continue;
+					}
+
+					any_input = true;
+					worst_loss = std::max(worst_loss, loss(r.candidates[k], r));
+					relative_time += r.candidates[k].milliseconds / r.baseline.milliseconds;
+				}
+
+				if (!any_input) {
+					continue;
+				}
+
+				/* Below the allowed loss only the time counts, above it only the loss. */
+
+				const auto effective_loss = std::max(worst_loss, max_density_loss);
+				const bool better = !found || effective_loss < best_loss || (effective_loss == best_loss && relative_time < best_time);
+
+				if (better) {
+					table[c][v] = candidates[k];
+					best_loss = effective_loss;
+					best_time = relative_time;
+					found = true;
+				}
+			}
+		}
+	}
+
+	/* How the table fares against discard_step = 1 with all orders. */
+
+	double tuned_time = 0;
+	double baseline_time = 0;
+	double worst_loss = 0;
+
+	for (const auto& r : results) {
+		const auto& chosen = table[r.count_class][r.variation_class];
+
+		for (std::size_t k = 0; k < candidates.size(); ++k) {
+			if (candidates[k].divisor == chosen.divisor && candidates[k].all_orders == chosen.all_orders) {
+				tuned_time += r.candidates[k].milliseconds;
+				baseline_time += r.baseline.milliseconds;
+				worst_loss = std::max(worst_loss, static_cast<double>(r.candidates[k].bin_area) / static_cast<double>(r.baseline.bin_area) - 1);
+			}
+		}
+	}
+
+	char summary[160];
+
+	std::snprintf(
+		summary,
+		sizeof(summary),
+		"Against discard_step = 1 with all orders: %.1f times less time, at most %.2f%% bigger bins.",
+		baseline_time / tuned_time,
+		worst_loss * 100
+	);
+
+	std::cerr << summary << "\n";
+
+	std::ofstream file;
+
+	if (!output_path.empty()) {
+		file.open(output_path);
+
+		if (!file) {
+			std::cerr << "Could not open " << output_path << " for writing.\n";
+			return 1;
+		}
+	}
+
+	std::ostream& out = output_path.empty() ? std::cout : file;
+
+	const auto write_list = [&out](const auto& values) {
+		out << "{ ";
+
+		for (std::size_t i = 0; i < std::size(values); ++i) {
+			out << (i > 0 ? ", " : "") << values[i];
+		}
+
+		out << " }";
+	};
+
+	const auto write_table = [&](const char* const declaration, const auto value_of) {
+		out << "\tinline constexpr " << declaration << "[" << count_classes << "][" << variation_classes << "] = {\n";
+
+		for (std::size_t c = 0; c < count_classes; ++c) {
+			std::array<std::string, variation_classes> row;
+
+			for (std::size_t v = 0; v < variation_classes; ++v) {
+				row[v] = value_of(table[c][v]);
+			}
+
+			out << "\t\t";
+			write_list(row);
+			out << (c + 1 < count_classes ? ",\n" : "\n");
+		}
+
+		out << "\t};\n";
+	};
+
+	out << "#pragma once\n#include <cstddef>\n\n";
+	out << "/*\n\tGenerated by rectpack2D-calibration (see calibration/main.cpp) - do not edit by hand.\n";
+	out << "\t" << summary << "\n*/\n\n";
+	out << "namespace rectpack2D {\n";
+
+	out << "\tinline constexpr std::size_t auto_tuner_count_bounds[] = ";
+	write_list(count_bounds);
+	out << ";\n";
+
+	out << "\tinline constexpr double auto_tuner_variation_bounds[] = ";
+	write_list(variation_bounds);
+	out << ";\n\n";
+
+	write_table("int auto_tuner_side_divisors", [](const candidate& c) { return std::to_string(c.divisor); });
+	out << "\n";
+	write_table("bool auto_tuner_all_orders", [](const candidate& c) { return std::string(c.all_orders ? "true" : "false"); });
+
+	out << "}\n";
+
+	return out ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <iostream>
+#include <type_traits>
+
+#include <rectpack2D/finders_interface.h>
+#include <rectpack2D/batch_finder.h>
+
+#include "mapped_file.h"
+#include "manifest.h"
+
+/*
+	Packs every atlas job of a manifest (see manifest.h) and streams the placements out as CSV:
+
+		bin,atlas,width,height
+		rect,atlas,index,x,y,flipped
+		unplaced,atlas,index
+
+	where index is the position of the rectangle within its job in the manifest.
+	Rectangles with an area of zero are never placed by the finders, so they are reported as unplaced.
+	The bin line of a job comes before the lines of its rectangles.
+
+	Jobs are packed in chunks with find_best_packing_batch, 
+	and every chunk is written out before the next one is packed.
+	If the output can't be written in full, e.g. on a full disk, this exits with 1.
+*/
+
+using namespace rectpack2D;
+
+using spaces_type = empty_spaces<true, default_empty_spaces>;
+using rect_type = output_rect_t<spaces_type>;
+
+struct cli_settings {
+	std::string manifest_path;
+	std::string output_path;
+
+	int max_side = 8192;
+	int discard_step = 1;
+	flipping_option flipping_mode = flipping_option::ENABLED;
+
+	unsigned threads = 0;
+	std::size_t chunk_jobs = 1024;
+};
+
+/* The rectangles of one job within the rectangles of a whole chunk. */
+
+struct job_rects {
+	rect_type* first;
+	rect_type* last;
+
+	rect_type* begin() const {
+		return first;
+	}
+
+	rect_type* end() const {
+		return last;
+	}
+
+	std::size_t size() const {
+		return static_cast<std::size_t>(last - first);
+	}
+};
+
+class output_stream {
+	std::FILE* file;
+	std::string buffer;
+	bool failed = false;
+
+public:
+	explicit output_stream(std::FILE* const file_) : file(file_) {
+		buffer.reserve(1 << 20);
+	}
+
+	/* Returns false if anything written so far did not make it to the file. */
+
+	bool flush() {
+		if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size() || std::fflush(file) != 0) {
+			failed = true;
+		}
+
+		buffer.clear();
+		return !failed;
+	}
+
+	output_stream& operator<<(const std::string_view text) {
+		buffer.append(text);
+		return *this;
+	}
+
+	output_stream& operator<<(const char c) {
+		buffer.push_back(c);
+		return *this;
+	}
+
+	template <class T, class = std::enable_if_t<std::is_integral_v<T>>>
+	output_stream& operator<<(const T number) {
+		char digits[24];
+		const auto written = std::to_chars(digits, digits + sizeof(digits), number);
+
+		buffer.append(digits, written.ptr);
+		return *this;
+	}
+
+	void flush_if_full() {
+		if (buffer.size() >= (1 << 20)) {
+			flush();
+		}
+	}
+};
+
+static void print_usage() {
+	std::cerr << 
+		"Usage: rectpack2D-cli [options] <manifest>\n"
+		"\n"
+		"Options:\n"
+		"  -o <file>             Write the placements to <file> instead of stdout.\n"
+		"  --max-side <n>        Maximum side of every bin. Default: 8192.\n"
+		"  --discard-step <n>    Discard step of the search. Default: 1.\n"
+		"  --no-flip             Never flip rectangles.\n"
+		"  --threads <n>         Worker threads. Default: 0, one per hardware thread.\n"
+		"  --chunk <n>           Jobs packed before their placements are written out. Default: 1024.\n";
+}
+
+static bool parse_settings(const int argc, char** const argv, cli_settings& settings) {
+	auto parse_number = [](const char* const text, auto& number) {
+		const auto end = text + std::char_traits<char>::length(text);
+		const auto parsed = std::from_chars(text, end, number);
+
+		return parsed.ec == std::errc() && parsed.ptr == end;
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		const auto arg = std::string_view(argv[i]);
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--no-flip") {
+			settings.flipping_mode = flipping_option::DISABLED;
+		}
+		else if (arg == "-o" && has_value) {
+			settings.output_path = argv[++i];
+		}
+		else if (arg == "--max-side" && has_value) {
+			if (!parse_number(argv[++i], settings.max_side) || settings.max_side <= 0) {
+				return false;
+			}
+		}
+		else if (arg == "--discard-step" && has_value) {
+			if (!parse_number(argv[++i], settings.discard_step)) {
+				return false;
+			}
+		}
+		else if (arg == "--threads" && has_value) {
+			if (!parse_number(argv[++i], settings.threads)) {
+				return false;
+			}
+		}
+		else if (arg == "--chunk" && has_value) {
+			if (!parse_number(argv[++i], settings.chunk_jobs) || settings.chunk_jobs == 0) {
+				return false;
+			}
+		}
+		else if (!arg.empty() && arg[0] != '-' && settings.manifest_path.empty()) {
+			settings.manifest_path = argv[i];
+		}
+		else {
+			return false;
+		}
+	}
+
+	return !settings.manifest_path.empty();
+}
+
+int main(const int argc, char** const argv) {
+	cli_settings settings;
+
+	if (!parse_settings(argc, argv, settings)) {
+		print_usage();
+		return 2;
+	}
+
+	try {
+		const mapped_file file(settings.manifest_path);
+		const auto jobs = parse_manifest(file.data(), file.size());
+
+		std::FILE* output_file = stdout;
+
+		if (!settings.output_path.empty()) {
+			output_file = std::fopen(settings.output_path.c_str(), "wb");
+
+			if (output_file == nullptr) {
+				std::cerr << "Could not open " << settings.output_path << " for writing.\n";
+				return 1;
+			}
+		}
+
+		std::vector<rect_type> rects;
+		std::vector<char> placed;
+		std::vector<job_rects> chunk;
+
+		/* Every rectangle is reported from one worker only, so the flags need no synchronization. */
+
+		auto input = make_finder_input(
+			settings.max_side,
+			settings.discard_step,
+			[&rects, &placed](rect_type& r) {
+				placed[static_cast<std::size_t>(&r - rects.data())] = 1;
+				return callback_result::CONTINUE_PACKING;
+			},
+			[](rect_type&) { return callback_result::CONTINUE_PACKING; },
+			settings.flipping_mode
+		);
+
+		batch_settings batch;
+		batch.workers = settings.threads;
+
+		bool written = false;
+
+		{
+			output_stream out(output_file);
+
+			for (std::size_t first_job = 0; first_job < jobs.jobs.size(); first_job += settings.chunk_jobs) {
+				const auto last_job = std::min(jobs.jobs.size(), first_job + settings.chunk_jobs);
+
+				const auto first_rect = jobs.jobs[first_job].first_rect;
+				const auto& final_job = jobs.jobs[last_job - 1];
+				const auto last_rect = final_job.first_rect + final_job.rect_count;
+
+				rects.clear();
+
+				for (auto i = first_rect; i < last_rect; ++i) {
+					rects.emplace_back(0, 0, jobs.sizes[i].w, jobs.sizes[i].h, false);
+				}
+
+				placed.assign(rects.size(), 0);
+
+				chunk.clear();
+
+				for (auto j = first_job; j < last_job; ++j) {
+					const auto& job = jobs.jobs[j];
+					const auto job_first = rects.data() + (job.first_rect - first_rect);
+
+					chunk.push_back({ job_first, job_first + job.rect_count });
+				}
+
+				const auto bins = find_best_packing_batch<spaces_type>(chunk, input, batch);
+
+				for (std::size_t k = 0; k < chunk.size(); ++k) {
+					const auto j = first_job + k;
+
+					auto write_name = [&]() -> output_stream& {
+						if (jobs.jobs[j].name.empty()) {
+							return out << j;
+						}
+
+						return out << jobs.jobs[j].name;
+					};
+
+					out << "bin,";
+					write_name() << ',' << bins[k].w << ',' << bins[k].h << '\n';
+
+					for (std::size_t i = 0; i < chunk[k].size(); ++i) {
+						const auto& r = chunk[k].first[i];
+
+						if (!placed[static_cast<std::size_t>(&r - rects.data())]) {
+							out << "unplaced,";
+							write_name() << ',' << i << '\n';
+						}
+						else {
+							out << "rect,";
+							write_name() << ',' << i << ',' << r.x << ',' << r.y << ',' << int(r.flipped) << '\n';
+						}
+					}
+
+					out.flush_if_full();
+				}
+			}
+
+			written = out.flush();
+		}
+
+		if (output_file != stdout && std::fclose(output_file) != 0) {
+			written = false;
+		}
+
+		if (!written) {
+			std::cerr << "Could not write the placements to " << (settings.output_path.empty() ? "stdout" : settings.output_path) << ".\n";
+			return 1;
+		}
+	}
+	catch (const std::exception& err) {
+		std::cerr << err.what() << '\n';
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+
+#include <rectpack2D/finders_interface.h>
+
+/*
+	Manifests list the sizes of the rectangles of any number of atlas jobs.
+
+	CSV manifests have one rectangle per line:
+
+		atlas,width,height
+
+	Consecutive lines naming the same atlas make up one job.
+	Empty lines, lines starting with # and a header line whose width is not a number are skipped.
+
+	Binary manifests are little-endian:
+
+		char     magic[4] = "RP2J"
+		uint32_t version  = 1
+		uint32_t job_count
+		job_count times:
+			uint32_t rect_count
+			rect_count times:
+				uint32_t width
+				uint32_t height
+
+	and their jobs are named by their index.
+*/
+
+struct manifest_job {
+	/* Points into the mapped manifest, or empty for binary manifests. */
+	std::string_view name;
+
+	std::size_t first_rect = 0;
+	std::size_t rect_count = 0;
+};
+
+struct manifest {
+	std::vector<manifest_job> jobs;
+	std::vector<rectpack2D::rect_wh> sizes;
+};
+
+inline bool is_binary_manifest(const char* const data, const std::size_t size) {
+	return size >= 4 && std::memcmp(data, "RP2J", 4) == 0;
+}
+
+inline manifest parse_binary_manifest(const char* const data, const std::size_t size) {
+	std::size_t offset = 4;
+
+	auto read_u32 = [&]() {
+		if (size - offset < 4) {
+			throw std::runtime_error("Binary manifest truncated at byte " + std::to_string(offset));
+		}
+
+		const auto bytes = reinterpret_cast<const unsigned char*>(data + offset);
+		offset += 4;
+
+		return std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 | std::uint32_t(bytes[2]) << 16 | std::uint32_t(bytes[3]) << 24;
+	};
+
+	auto read_side = [&]() {
+		const auto side = read_u32();
+
+		if (side > std::uint32_t(std::numeric_limits<int>::max())) {
+			throw std::runtime_error("Side too big at byte " + std::to_string(offset - 4));
+		}
+
+		return static_cast<int>(side);
+	};
+
+	if (const auto version = read_u32(); version != 1) {
+		throw std::runtime_error("Unsupported binary manifest version " + std::to_string(version));
+	}
+
+	manifest result;
+
+	const auto job_count = read_u32();
+
+	/* Never trust the counts for reserving more than the file could hold. */
+	result.jobs.reserve(std::min<std::size_t>(job_count, size / 4));
+	result.sizes.reserve((size - offset) / 8);
+
+	for (std::uint32_t j = 0; j < job_count; ++j) {
+		manifest_job job;
+		job.first_rect = result.sizes.size();
+		job.rect_count = read_u32();
+
+		for (std::size_t i = 0; i < job.rect_count; ++i) {
+			const auto w = read_side();
+			const auto h = read_side();
+
+			result.sizes.emplace_back(w, h);
+		}
+
+		result.jobs.push_back(job);
+	}
+
+	return result;
+}
+
+inline manifest parse_csv_manifest(const char* const data, const std::size_t size) {
+	manifest result;
+
+	const char* line = data;
+	const char* const end = data + size;
+	std::size_t line_number = 0;
+
+	auto fail = [&](const char* const what) {
+		throw std::runtime_error(std::string(what) + " at line " + std::to_string(line_number));
+	};
+
+	while (line < end) {
+		++line_number;
+
+		auto line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<std::size_t>(end - line)));
+
+		if (line_end == nullptr) {
+			line_end = end;
+		}
+
+		const char* next_line = line_end == end ? end : line_end + 1;
+
+		if (line_end > line && line_end[-1] == '\r') {
+			--line_end;
+		}
+
+		if (line == line_end || *line == '#') {
+			line = next_line;
+			continue;
+		}
+
+		const auto first_comma = static_cast<const char*>(std::memchr(line, ',', static_cast<std::size_t>(line_end - line)));
+
+		if (first_comma == nullptr) {
+			fail("Expected atlas,width,height");
+		}
+
+		const auto name = std::string_view(line, static_cast<std::size_t>(first_comma - line));
+
+		int w = 0;
+		int h = 0;
+
+		const auto parsed_w = std::from_chars(first_comma + 1, line_end, w);
+
+		if (parsed_w.ec != std::errc()) {
+			if (result.sizes.empty()) {
+				/* A header. */
+				line = next_line;
+				continue;
+			}
+
+			fail("Invalid width");
+		}
+
+		if (parsed_w.ptr == line_end || *parsed_w.ptr != ',') {
+			fail("Expected atlas,width,height");
+		}
+
+		const auto parsed_h = std::from_chars(parsed_w.ptr + 1, line_end, h);
+
+		if (parsed_h.ec != std::errc() || parsed_h.ptr != line_end) {
+			fail("Invalid height");
+		}
+
+		if (w < 0 || h < 0) {
+			fail("Negative size");
+		}
+
+		if (result.jobs.empty() || result.jobs.back().name != name) {
+			manifest_job job;
+			job.name = name;
+			job.first_rect = result.sizes.size();
+
+			result.jobs.push_back(job);
+		}
+
+		result.sizes.emplace_back(w, h);
+		++result.jobs.back().rect_count;
+
+		line = next_line;
+	}
+
+	return result;
+}
+
+inline manifest parse_manifest(const char* const data, const std::size_t size) {
+	if (is_binary_manifest(data, size)) {
+		return parse_binary_manifest(data, size);
+	}
+
+	return parse_csv_manifest(data, size);
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+	A read-only view of a whole file, mapped into memory,
+	so that manifests of any size are parsed in place without being read into buffers first.
+*/
+
+class mapped_file {
+	const char* first = nullptr;
+	std::size_t length = 0;
+
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int descriptor = -1;
+#endif
+
+	void close() {
+#if defined(_WIN32)
+		if (first) {
+			UnmapViewOfFile(first);
+		}
+
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+#else
+		if (first && length > 0) {
+			munmap(const_cast<char*>(first), length);
+		}
+
+		if (descriptor != -1) {
+			::close(descriptor);
+		}
+#endif
+	}
+
+public:
+	explicit mapped_file(const std::string& path) {
+		const auto fail = [&]() {
+			close();
+			throw std::runtime_error("Could not map " + path);
+		};
+
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		LARGE_INTEGER size;
+
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+			fail();
+		}
+
+		length = static_cast<std::size_t>(size.QuadPart);
+
+		if (length == 0) {
+			return;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (!mapping) {
+			fail();
+		}
+
+		first = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (!first) {
+			fail();
+		}
+#else
+		descriptor = ::open(path.c_str(), O_RDONLY);
+
+		struct stat info;
+
+		if (descriptor == -1 || fstat(descriptor, &info) != 0) {
+			fail();
+		}
+
+		length = static_cast<std::size_t>(info.st_size);
+
+		if (length == 0) {
+			return;
+		}
+
+		void* const view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+		if (view == MAP_FAILED) {
+			fail();
+		}
+
+		first = static_cast<const char*>(view);
+
+		/* Manifests are parsed front to back exactly once. */
+		madvise(view, length, MADV_SEQUENTIAL);
+#endif
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file() {
+		close();
+	}
+
+	const char* data() const {
+		return first;
+	}
+
+	std::size_t size() const {
+		return length;
+	}
+};
@@ -20,6 +20,11 @@ int main() {
 		The default one just uses a vector to store the spaces.
 		You can also pass a "static_empty_spaces<10000>" which will allocate 10000 spaces on the stack,
 		possibly improving performance.
+		A "pmr_empty_spaces" takes its storage from a std::pmr::memory_resource of your choice.
+
+		The third argument is optional and decides which empty space each rectangle goes into
+		(see src/rectpack2D/space_selection.h). The default is the fastest, 
+		e.g. "best_area_fit<64>" packs tighter at the cost of some speed.
 	*/
 
 	using spaces_type = rectpack2D::empty_spaces<allow_flip, default_empty_spaces>;
@@ -71,6 +76,9 @@ int main() {
 		If you are dealing with very small rectangles specifically,
 		it might be a good idea to make this value negative.
 
+		Alternatively, find_best_packing_tuned (see src/rectpack2D/auto_tuner.h)
+		picks it for you from the statistics of the input.
+
 		See the algorithm section of README for more information.
 	*/
 
@@ -0,0 +1,166 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <functional>
+#include "best_bin_finder.h"
+
+namespace rectpack2D {
+	enum class bin_objective {
+		MIN_AREA,
+		MIN_MAX_SIDE
+	};
+
+	struct aspect_sweep_settings {
+		/*
+			Width to height ratios of the starting bins.
+			The longer side of each starting bin is max_bin_side, so no bin will ever exceed it.
+
+			1 is the square search done by find_best_packing.
+		*/
+		std::vector<double> aspect_ratios = { 1.0, 2.0, 0.5, 4.0, 0.25, 8.0, 0.125 };
+
+		bin_objective objective = bin_objective::MIN_AREA;
+
+		/*
+			If set, called once with the number of aspect ratios and a task to run for each index -
+			e.g. on a thread pool of your own - returning once all of them have completed.
+			The tasks that run on threads other than the caller's use thread_local_root instead of the root passed by the caller.
+
+			If empty, the aspect ratios are searched one after another on the calling thread,
+			with the root passed by the caller, so nothing is allocated.
+		*/
+		std::function<void(std::size_t count, const std::function<void(std::size_t)>& task)> parallel_for;
+	};
+
+	template <class area_type, class R>
+	bool better_bin(const bin_objective objective, const R& a, const R& b) {
+		if (objective == bin_objective::MIN_MAX_SIDE && a.max_side() != b.max_side()) {
+			return a.max_side() < b.max_side();
+		}
+
+		return area_as<area_type>(a) < area_as<area_type>(b);
+	}
+
+	/*
+		This function will run find_best_order once for every aspect ratio of the starting bin,
+		and then pick the best bin according to the objective.
+
+		Elongated inputs, e.g. long UI strips, can end up in much smaller bins this way,
+		since the square search can only shrink one dimension at a time after the initial square is found.
+
+		Ties are resolved in favor of the earlier aspect ratio,
+		so the result does not depend on settings.parallel_for or the scheduling of threads.
+	*/
+
+	template <
+		class empty_spaces_type,
+		class order_type,
+		class F,
+		class I
+	>
+	auto find_best_packing_aspect_sweep_impl(
+		empty_spaces_type& root,
+		F for_each_order,
+		const I& input,
+		const aspect_sweep_settings& settings
+	) {
+		using coord_type = typename empty_spaces_type::coord_type;
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+		using area_type = search_area_t<empty_spaces_type, typename I::area_type>;
+		using result_type = best_order_result<order_type, rect_wh_type, area_type>;
+
+		const auto& constraint = input.bin_constraint;
+		const auto& ratios = settings.aspect_ratios;
+
+		assert(!ratios.empty());
+
+		const auto starting_bin_for = [&](const double ratio) {
+			const auto max_side = input.max_bin_side;
+			auto bin = rect_wh_type(max_side, max_side);
+
+			if (ratio >= 1.0) {
+				bin.h = static_cast<coord_type>(std::max(1.0, max_side / ratio));
+			}
+			else {
+				bin.w = static_cast<coord_type>(std::max(1.0, max_side * ratio));
+			}
+
+			return constraint.side_of(constraint.index_of(bin));
+		};
+
+		/* Whether the candidate beats the current best - on a tie, the earlier one stays. */
+
+		const auto better = [&](const result_type& candidate, const result_type& current) {
+			if (candidate.found_bin != current.found_bin) {
+				return candidate.found_bin;
+			}
+
+			if (candidate.found_bin) {
+				return better_bin<area_type>(settings.objective, candidate.bin, current.bin);
+			}
+
+			return candidate.total_inserted > current.total_inserted;
+		};
+
+		result_type best;
+
+		if (!settings.parallel_for) {
+			for (std::size_t i = 0; i < ratios.size(); ++i) {
+				const auto result = find_best_order<empty_spaces_type, order_type>(
+					root,
+					for_each_order,
+					starting_bin_for(ratios[i]),
+					input
+				);
+
+				if (i == 0 || better(result, best)) {
+					best = result;
+				}
+			}
+		}
+		else {
+			std::vector<result_type> results(ratios.size());
+			std::vector<search_stats> stats(ratios.size());
+
+			const auto caller = std::this_thread::get_id();
+
+			const auto search = [&](const std::size_t i) {
+				/* References the callbacks of the input instead of copying them. */
+
+				auto ratio_input = make_finder_input_from(input, input.handle_successful_insertion, input.handle_unsuccessful_insertion);
+				ratio_input.stats = input.stats ? &stats[i] : nullptr;
+
+				auto& searching_root = std::this_thread::get_id() == caller ? root : thread_local_root<empty_spaces_type>();
+
+				results[i] = find_best_order<empty_spaces_type, order_type>(
+					searching_root,
+					for_each_order,
+					starting_bin_for(ratios[i]),
+					ratio_input
+				);
+			};
+
+			/* Captures a single reference, so that it fits into the small buffer of std::function. */
+
+			settings.parallel_for(ratios.size(), [&search](const std::size_t i) { search(i); });
+
+			best = results[0];
+
+			for (std::size_t i = 1; i < results.size(); ++i) {
+				if (better(results[i], best)) {
+					best = results[i];
+				}
+			}
+
+			if (input.stats) {
+				for (const auto& s : stats) {
+					input.stats->trials += s.trials;
+				}
+			}
+		}
+
+		assert(best.order.has_value());
+
+		return write_packing(root, *best.order, best.bin, input);
+	}
+}
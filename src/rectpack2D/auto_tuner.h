@@ -0,0 +1,177 @@
+#pragma once
+#include <cmath>
+#include <iterator>
+#include "finders_interface.h"
+#include "auto_tuner_table.h"
+
+namespace rectpack2D {
+	struct input_statistics {
+		/* Only the rectangles with a non-zero area. */
+		std::size_t count = 0;
+
+		double total_area = 0;
+
+		/* Standard deviation of the areas divided by their mean. */
+		double area_variation = 0;
+
+		/* Whether every rectangle is a square, so that flipping can't change anything. */
+		bool all_square = true;
+	};
+
+	enum class tuned_orders {
+		/* Only the order by decreasing area. */
+		AREA,
+
+		/* All orders of with_default_comparators. */
+		ALL_DEFAULT
+	};
+
+	struct tuned_settings {
+		input_statistics statistics;
+
+		int discard_step = 1;
+		flipping_option flipping_mode = flipping_option::ENABLED;
+		tuned_orders orders = tuned_orders::ALL_DEFAULT;
+	};
+
+	template <class area_type, class Subjects>
+	input_statistics gather_input_statistics(const Subjects& subjects) {
+		input_statistics result;
+
+		double sum_of_squares = 0;
+
+		for (const auto& s : subjects) {
+			const auto& r = s.get_rect();
+			const auto area = static_cast<double>(area_as<area_type>(r));
+
+			if (area == 0) {
+				continue;
+			}
+
+			++result.count;
+			result.total_area += area;
+			sum_of_squares += area * area;
+
+			if (r.w != r.h) {
+				result.all_square = false;
+			}
+		}
+
+		if (result.count > 0) {
+			const auto mean = result.total_area / result.count;
+			const auto variance = std::max(0.0, sum_of_squares / result.count - mean * mean);
+
+			result.area_variation = std::sqrt(variance) / mean;
+		}
+
+		return result;
+	}
+
+	/* The discard_step for a divisor of auto_tuner_side_divisors. */
+
+	inline int tuned_discard_step(const input_statistics& statistics, const int side_divisor) {
+		if (side_divisor == 0) {
+			return -4;
+		}
+
+		return std::max(1, static_cast<int>(std::sqrt(statistics.total_area) / side_divisor));
+	}
+
+	/*
+		Picks discard_step and the orders from the statistics of the input,
+		with the rules of auto_tuner_table.h.
+
+		The inputs are classed by their count and by the variation of their areas,
+		and every class has the divisor of the expected bin side that gives discard_step
+		(0 for the finest search, discard_step = -4) and whether to try all five default orders or just the one by area.
+
+		The table is generated by rectpack2D-calibration (see calibration/main.cpp),
+		which packs synthetic inputs of several size distributions with every candidate setting
+		and keeps, for every class, the fastest setting packing within 0.5% of the densest one on all of its inputs.
+		It prints how much time and density the table costs against discard_step = 1 with all orders.
+		Your data may differ from ours - run it on inputs like yours, or compare against your hand-tuned settings,
+		before relying on this.
+
+		Flipping is turned off only when all rectangles are squares, where it can't change the packing -
+		and never turned on if the input disables it.
+	*/
+
+	template <class F, class G, class A>
+	tuned_settings tune_finder_settings(const input_statistics& statistics, const finder_input<F, G, A>& input) {
+		tuned_settings result;
+		result.statistics = statistics;
+		result.flipping_mode = statistics.all_square ? flipping_option::DISABLED : input.flipping_mode;
+
+		const auto class_of = [](const auto value, const auto& bounds) {
+			std::size_t index = 0;
+
+			while (index < std::size(bounds) && value >= bounds[index]) {
+				++index;
+			}
+
+			return index;
+		};
+
+		const auto count_class = class_of(statistics.count, auto_tuner_count_bounds);
+		const auto variation_class = class_of(statistics.area_variation, auto_tuner_variation_bounds);
+
+		result.discard_step = tuned_discard_step(statistics, auto_tuner_side_divisors[count_class][variation_class]);
+		result.orders = auto_tuner_all_orders[count_class][variation_class] ? tuned_orders::ALL_DEFAULT : tuned_orders::AREA;
+
+		return result;
+	}
+
+	/*
+		Same as find_best_packing with the default comparators,
+		but ignores discard_step of the input and picks it - along with flipping and the orders - with tune_finder_settings.
+		Pass chosen to learn which settings were picked.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_tuned(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		tuned_settings* const chosen = nullptr
+	) {
+		using area_type = search_area_t<empty_spaces_type, A>;
+
+		const auto settings = tune_finder_settings(gather_input_statistics<area_type>(subjects), input);
+
+		if (chosen) {
+			*chosen = settings;
+		}
+
+		const auto tuned_input = make_finder_input_from(
+			input,
+			input.handle_successful_insertion,
+			input.handle_unsuccessful_insertion,
+			settings.discard_step,
+			settings.flipping_mode
+		);
+
+		return with_default_comparators<empty_spaces_type, area_type>(
+			[&](auto by_area, auto... other_comparators) {
+				if (settings.orders == tuned_orders::AREA) {
+					return find_best_packing<empty_spaces_type>(scratch, subjects, tuned_input, by_area);
+				}
+
+				return find_best_packing<empty_spaces_type>(scratch, subjects, tuned_input, by_area, other_comparators...);
+			}
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_tuned(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		tuned_settings* const chosen = nullptr
+	) {
+		return find_best_packing_tuned<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input,
+			chosen
+		);
+	}
+}
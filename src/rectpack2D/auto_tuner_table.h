@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+/*
+	Generated by rectpack2D-calibration (see calibration/main.cpp) - do not edit by hand.
+	Against discard_step = 1 with all orders: 1.4 times less time, at most 1.04% bigger bins.
+*/
+
+namespace rectpack2D {
+	inline constexpr std::size_t auto_tuner_count_bounds[] = { 100, 1000 };
+	inline constexpr double auto_tuner_variation_bounds[] = { 1 };
+
+	inline constexpr int auto_tuner_side_divisors[3][2] = {
+		{ 32, 512 },
+		{ 128, 128 },
+		{ 0, 32 }
+	};
+
+	inline constexpr bool auto_tuner_all_orders[3][2] = {
+		{ true, true },
+		{ true, true },
+		{ false, true }
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <future>
+#include <vector>
+#include <memory_resource>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	struct batch_settings {
+		/* 0 means std::thread::hardware_concurrency(). */
+		unsigned workers = 0;
+	};
+
+	/*
+		Runs find_best_packing for every job, e.g. thousands of tiny per-font atlases at once,
+		where jobs is a container of Subjects containers.
+		Returns the bin of every job, in the order of jobs.
+
+		The jobs are spread over a number of worker threads,
+		each with its own root and its own pool for the orders,
+		both reused from one job to the next - so after the first few jobs, nothing is allocated anymore.
+
+		The callbacks of the input are shared by all jobs,
+		and will be called from several threads at once.
+	*/
+
+	template <class empty_spaces_type, class Jobs, class F, class G, class A>
+	std::vector<rect_wh_t<empty_spaces_type>> find_best_packing_batch(
+		Jobs& jobs,
+		const finder_input<F, G, A>& input,
+		const batch_settings& settings = batch_settings()
+	) {
+		using rect_wh_type = rect_wh_t<empty_spaces_type>;
+
+		const auto job_count = static_cast<std::size_t>(std::size(jobs));
+		std::vector<rect_wh_type> results(job_count);
+
+		std::vector<decltype(std::addressof(*std::begin(jobs)))> job_list;
+		job_list.reserve(job_count);
+
+		for (auto& j : jobs) {
+			job_list.push_back(std::addressof(j));
+		}
+
+		const auto hardware_workers = std::max(1u, std::thread::hardware_concurrency());
+		const auto requested_workers = settings.workers == 0 ? hardware_workers : settings.workers;
+		const auto worker_count = std::min<std::size_t>(requested_workers, job_count);
+
+		std::atomic<std::size_t> next_job = 0;
+		std::vector<search_stats> stats(worker_count);
+
+		const auto work = [&](const std::size_t worker) {
+			empty_spaces_type root { rect_wh_type() };
+			std::pmr::unsynchronized_pool_resource orders_memory;
+
+			const auto scratch = make_finder_scratch(root, &orders_memory);
+
+			auto worker_input = make_finder_input_from(input, input.handle_successful_insertion, input.handle_unsuccessful_insertion);
+			worker_input.stats = input.stats ? &stats[worker] : nullptr;
+
+			for (auto i = next_job++; i < job_count; i = next_job++) {
+				results[i] = find_best_packing<empty_spaces_type>(scratch, *job_list[i], worker_input);
+			}
+		};
+
+		std::vector<std::future<void>> pending;
+
+		for (std::size_t w = 1; w < worker_count; ++w) {
+			pending.emplace_back(std::async(std::launch::async, work, w));
+		}
+
+		if (worker_count > 0) {
+			work(0);
+		}
+
+		for (auto& p : pending) {
+			p.get();
+		}
+
+		if (input.stats) {
+			for (const auto& s : stats) {
+				input.stats->trials += s.trials;
+			}
+		}
+
+		return results;
+	}
+}
@@ -1,8 +1,10 @@
 #pragma once
+#include <vector>
 #include <variant>
 #include <cassert>
 #include <optional>
 #include "rect_structs.h"
+#include "bin_size_constraint.h"
 
 namespace rectpack2D {
 	template <class T>
@@ -10,13 +12,13 @@ namespace rectpack2D {
 		T first;
 		T second;
 	public:
-		span(T first_, T second_) : first(first_), second(second_) {}
+		constexpr span(T first_, T second_) : first(first_), second(second_) {}
 
-		T begin() const {
+		constexpr T begin() const {
 			return first;
 		}
 
-		T end() const {
+		constexpr T end() const {
 			return second;
 		}
 	};
@@ -27,7 +29,7 @@ namespace rectpack2D {
 	};
 
 	template <class T>
-	auto& dereference(T& r) {
+	constexpr auto& dereference(T& r) {
 		/* 
 			This will allow us to pass orderings that consist of pointers,
 			as well as ones that are just plain objects in a vector.
@@ -49,7 +51,7 @@ namespace rectpack2D {
 		AND the bin size to be tried next differs in size from the last viable one by *less* then discard_step.
 
 		If we could not insert all input rectangles into a bin even as big as the starting_bin - the search fails.
-		In this case, we return the amount of space (total_area_type) inserted in total.
+		In this case, we return the amount of space (search_area_t) inserted in total.
 
 		If we've found a viable bin that is smaller or equal to starting_bin, the search succeeds.
 		In this case, we return the viable bin (rect_wh).
@@ -61,54 +63,235 @@ namespace rectpack2D {
 		HEIGHT
 	};
 
-	template <class empty_spaces_type, class O>
-	std::variant<total_area_type, rect_wh> best_packing_for_ordering_impl(
+	/*
+		The type in which the search computes and accumulates areas.
+
+		By default (A = void), it is fast_area_type_t of the coordinates - a plain int for int coordinates,
+		which is the fastest but overflows for bins bigger than about 46341 x 46341.
+		Pass e.g. std::int64_t to make_finder_input to search such bins correctly.
+	*/
+
+	template <class empty_spaces_type, class A = void>
+	using search_area_t = std::conditional_t<
+		std::is_void_v<A>,
+		fast_area_type_t<typename empty_spaces_type::coord_type>,
+		A
+	>;
+
+	template <class empty_spaces_type, class area_type>
+	using search_result_t = std::variant<
+		area_type,
+		typename empty_spaces_type::rect_wh_type
+	>;
+
+	/*
+		Counts the work done by the finders.
+		Point finder_input::stats to an instance to have it filled.
+	*/
+
+	struct search_stats {
+		/* A trial is a single attempt to insert an order into a candidate bin. */
+		std::size_t trials = 0;
+	};
+
+	/*
+		With space_pruning_option::ENABLED, the empty spaces that none of the remaining rectangles could fit into
+		are skipped by every later insertion (see find_smallest_remaining below).
+		The placements are exactly the same as without pruning.
+
+		This pays off when even the smallest rectangles are big enough for many slivers to be left behind,
+		e.g. it was two to three times faster with sides between 20 and 60 in our measurements.
+		It is opt-in because finding the smallest remaining rectangles takes an allocation and a pass over every order,
+		which is wasted when some rectangles are tiny.
+	*/
+
+	enum class space_pruning_option {
+		DISABLED,
+		ENABLED
+	};
+
+	/*
+		Once an order has fitted into some bin, no later order can win with a bigger one.
+		With incumbent_bound_option::ENABLED, a later order stops shrinking the height of its bin
+		as soon as even the lowest height the bisection could still reach,
+		times the width it has settled on, is bigger in area than the best bin so far.
+		That order could then only end with a bigger bin, so it loses either way,
+		and the result is exactly the same as without the bound.
+
+		The square and width passes are followed by the height pass, which could still shrink the bin a lot,
+		so nothing is cut there.
+		With the default orders, this saved 12-16% of the trials in our measurements.
+		It is enabled by make_finder_input - set DISABLED only to count the trials of the full search.
+	*/
+
+	enum class incumbent_bound_option {
+		DISABLED,
+		ENABLED
+	};
+
+	/*
+		For every position in the order, finds the smallest width and height
+		among the rectangles from that position to the end -
+		or just the smallest side, if the rectangles can be flipped.
+
+		With space_pruning_option::ENABLED, the search passes these to empty_spaces::prune_spaces_below
+		before each insertion, so that slivers which no remaining rectangle could fill
+		stop being scanned over and over.
+	*/
+
+	template <class rect_wh_type, class O, class I>
+	void find_smallest_remaining(
+		std::vector<rect_wh_type>& smallest_remaining,
+		const O& order,
+		const I& input
+	) {
+		smallest_remaining.clear();
+
+		for (const auto& r : order) {
+			smallest_remaining.push_back(input.bin_constraint.align(dereference(r).get_rect().get_wh()));
+		}
+
+		const bool flipping = input.flipping_mode == flipping_option::ENABLED;
+
+		for (std::size_t i = smallest_remaining.size(); i-- > 0;) {
+			auto& smallest = smallest_remaining[i];
+
+			if (flipping) {
+				smallest.w = smallest.h = smallest.min_side();
+			}
+
+			if (i + 1 < smallest_remaining.size()) {
+				const auto& next = smallest_remaining[i + 1];
+
+				smallest.w = std::min(smallest.w, next.w);
+				smallest.h = std::min(smallest.h, next.h);
+			}
+		}
+	}
+
+	template <class area_type, class empty_spaces_type, class O, class I>
+	constexpr search_result_t<empty_spaces_type, area_type> best_packing_for_ordering_impl(
 		empty_spaces_type& root,
 		O ordering,
-		const rect_wh starting_bin,
-		int discard_step,
-		const bin_dimension tried_dimension
+		const typename empty_spaces_type::rect_wh_type starting_bin,
+		const bin_dimension tried_dimension,
+		const I& input,
+		const typename empty_spaces_type::rect_wh_type* const smallest_remaining,
+		const std::optional<area_type> incumbent_area
 	) {
-		auto candidate_bin = starting_bin;
+		using coord_type = typename empty_spaces_type::coord_type;
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+
+		const auto& constraint = input.bin_constraint;
+		int discard_step = input.discard_step;
+
+		/*
+			The bisection runs over indices of legal bin sides (see bin_size_constraint).
+			Without a constraint, these are just the sides.
+		*/
+
+		const auto starting_index = constraint.index_of(starting_bin);
+		auto candidate_index = starting_index;
 		int tries_before_discarding = 0;
 
+		/*
+			When trying both dimensions, the height follows the width
+			so that the aspect ratio of starting_bin is kept.
+			For the usual square starting_bin, they are simply equal.
+		*/
+
+		const auto height_for = [starting_index](const coord_type w) {
+			if (starting_index.w == starting_index.h || starting_index.w == 0) {
+				return w;
+			}
+
+			return static_cast<coord_type>(static_cast<area_type>(w) * starting_index.h / starting_index.w);
+		};
+
 		if (discard_step <= 0) {
 			tries_before_discarding = -discard_step;
 			discard_step = 1;
 		}
+
+		discard_step = constraint.index_step(discard_step);
 		
 		//std::cout << "best_packing_for_ordering_impl dim: " << int(tried_dimension) << " w: " << starting_bin.w << " h: " << starting_bin.h << std::endl;
 
 		int starting_step = 0;
 
 		if (tried_dimension == bin_dimension::BOTH) {
-			candidate_bin.w /= 2;
-			candidate_bin.h /= 2;
+			candidate_index.w /= 2;
+			candidate_index.h = height_for(candidate_index.w);
 
-			starting_step = candidate_bin.w / 2;
+			starting_step = candidate_index.w / 2;
 		}
 		else if (tried_dimension == bin_dimension::WIDTH) {
-			candidate_bin.w /= 2;
-			starting_step = candidate_bin.w / 2;
+			candidate_index.w /= 2;
+			starting_step = candidate_index.w / 2;
 		}
 		else {
-			candidate_bin.h /= 2;
-			starting_step = candidate_bin.h / 2;
+			candidate_index.h /= 2;
+			starting_step = candidate_index.h / 2;
 		}
 
+		/*
+			The lowest height the bisection can still reach from candidate_index and step,
+			which is where it would end if every attempt from now on was successful -
+			every failure only sends it up, and later steps are never longer.
+		*/
+
+		const auto lowest_reachable_height = [&](int step, int tries) {
+			int index = candidate_index.h;
+
+			for (; ; step = std::max(1, step / 2)) {
+				if (step <= discard_step) {
+					if (tries == 0) {
+						return index;
+					}
+
+					--tries;
+				}
+
+				index -= step;
+			}
+		};
+
 		for (int step = starting_step; ; step = std::max(1, step / 2)) {
-			//std::cout << "candidate: " << candidate_bin.w << "x" << candidate_bin.h << std::endl;
+			//std::cout << "candidate: " << candidate_index.w << "x" << candidate_index.h << std::endl;
 
-			root.reset(candidate_bin);
+			const auto candidate_bin = constraint.side_of(candidate_index);
 
-			int total_inserted_area = 0;
+			/* See incumbent_bound_option. */
+
+			if (incumbent_area.has_value()) {
+				const auto lowest_height = std::max(0, lowest_reachable_height(step, tries_before_discarding));
+				const auto lowest_bin = constraint.side_of(rect_wh_type(candidate_index.w, static_cast<coord_type>(lowest_height)));
+
+				if (area_as<area_type>(lowest_bin) > *incumbent_area) {
+					return area_type(0);
+				}
+			}
+
+			area_type total_inserted_area = 0;
 
 			const bool all_inserted = [&]() {
+				root.reset(candidate_bin);
+
+				if (input.stats) {
+					++input.stats->trials;
+				}
+
+				std::size_t position = 0;
+
 				for (const auto& r : ordering) {
 					const auto& rect = dereference(r).get_rect();
 
-					if (root.insert(rect.get_wh())) {
-						total_inserted_area += rect.area();
+					if (smallest_remaining) {
+						root.prune_spaces_below(smallest_remaining[position++]);
+					}
+
+					if (root.insert(constraint.align(rect.get_wh()))) {
+						total_inserted_area += area_as<area_type>(rect);
 					}
 					else {
 						return false;
@@ -133,40 +316,40 @@ namespace rectpack2D {
 				}
 
 				if (tried_dimension == bin_dimension::BOTH) {
-					candidate_bin.w -= step;
-					candidate_bin.h -= step;
+					candidate_index.w -= step;
+					candidate_index.h = height_for(candidate_index.w);
 				}
 				else if (tried_dimension == bin_dimension::WIDTH) {
-					candidate_bin.w -= step;
+					candidate_index.w -= step;
 				}
 				else {
-					candidate_bin.h -= step;
+					candidate_index.h -= step;
 				}
 
-				root.reset(candidate_bin);
+				root.reset(constraint.side_of(candidate_index));
 			}
 			else {
 				/* Attempt ended with failure. Try with a bigger bin. */
 
 				if (tried_dimension == bin_dimension::BOTH) {
-					candidate_bin.w += step;
-					candidate_bin.h += step;
+					candidate_index.w += step;
+					candidate_index.h = height_for(candidate_index.w);
 
-					if (candidate_bin.area() > starting_bin.area()) {
+					if (area_as<area_type>(constraint.side_of(candidate_index)) > area_as<area_type>(starting_bin)) {
 						return total_inserted_area;
 					}
 				}
 				else if (tried_dimension == bin_dimension::WIDTH) {
-					candidate_bin.w += step;
+					candidate_index.w += step;
 
-					if (candidate_bin.w > starting_bin.w) {
+					if (candidate_index.w > starting_index.w) {
 						return total_inserted_area;
 					}
 				}
 				else {
-					candidate_bin.h += step;
+					candidate_index.h += step;
 
-					if (candidate_bin.h > starting_bin.h) {
+					if (candidate_index.h > starting_index.h) {
 						return total_inserted_area;
 					}
 				}
@@ -174,38 +357,44 @@ namespace rectpack2D {
 		}
 	}
 
-	template <class empty_spaces_type, class O>
-	std::variant<total_area_type, rect_wh> best_packing_for_ordering(
+	template <class area_type, class empty_spaces_type, class O, class I>
+	constexpr search_result_t<empty_spaces_type, area_type> best_packing_for_ordering(
 		empty_spaces_type& root,
 		O&& ordering,
-		const rect_wh starting_bin,
-		const int discard_step
+		const typename empty_spaces_type::rect_wh_type starting_bin,
+		const I& input,
+		const typename empty_spaces_type::rect_wh_type* const smallest_remaining = nullptr,
+		const std::optional<area_type> incumbent_area = std::nullopt
 	) {
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+
 		const auto try_pack = [&](
 			const bin_dimension tried_dimension, 
-			const rect_wh candidate_starting_bin
+			const rect_wh_type candidate_starting_bin
 		) {
-			return best_packing_for_ordering_impl(
+			return best_packing_for_ordering_impl<area_type>(
 				root,
 				std::forward<O>(ordering),
 				candidate_starting_bin,
-				discard_step,
-				tried_dimension
+				tried_dimension,
+				input,
+				smallest_remaining,
+				tried_dimension == bin_dimension::HEIGHT ? incumbent_area : std::nullopt
 			);
 		};
 
 		const auto best_result = try_pack(bin_dimension::BOTH, starting_bin);
 
-		if (const auto failed = std::get_if<total_area_type>(&best_result)) {
+		if (const auto failed = std::get_if<area_type>(&best_result)) {
 			return *failed;
 		}
 
-		auto best_bin = std::get<rect_wh>(best_result);
+		auto best_bin = std::get<rect_wh_type>(best_result);
 
 		auto try_dimension = [&](const bin_dimension tried_dimension) {
 			const auto trial = try_pack(tried_dimension, best_bin);
 
-			if (const auto better = std::get_if<rect_wh>(&trial)) {
+			if (const auto better = std::get_if<rect_wh_type>(&trial)) {
 				best_bin = *better;
 			}
 		};
@@ -216,11 +405,43 @@ namespace rectpack2D {
 		return best_bin;
 	}
 
+	/* 
+		Unless the caller passes its own root, the finders re-use this one on the TLS.
+		It is always reset before any packing attempt.
+
+		Its storage is never shrunk - call release_thread_local_root
+		to free the memory after an unusually large packing.
+	*/
+
+	template <class empty_spaces_type>
+	empty_spaces_type& thread_local_root() {
+		thread_local empty_spaces_type root = typename empty_spaces_type::rect_wh_type();
+		return root;
+	}
+
+	template <class empty_spaces_type>
+	void release_thread_local_root() {
+		thread_local_root<empty_spaces_type>() = empty_spaces_type(typename empty_spaces_type::rect_wh_type());
+	}
+
 	/*
-		This function will try to find the best bin size among the ones generated by all provided rectangle orders.
-		Only the best order will have results written to.
+		The outcome of find_best_order.
 
-		The function reports which of the rectangles did and did not fit in the end.
+		If found_bin is false, no order fitted into the starting bin,
+		and order is the one that inserted the most area (total_inserted) before failing.
+	*/
+
+	template <class order_type, class rect_wh_type, class area_type>
+	struct best_order_result {
+		std::optional<order_type> order;
+		rect_wh_type bin;
+		bool found_bin = false;
+		area_type total_inserted = -1;
+	};
+
+	/*
+		This function will try to find the best bin size among the ones generated by all provided rectangle orders,
+		starting the search of each order from starting_bin.
 	*/
 
 	template <
@@ -229,60 +450,110 @@ namespace rectpack2D {
 		class F,
 		class I
 	>
-	rect_wh find_best_packing_impl(F for_each_order, const I input) {
-		const auto max_bin = rect_wh(input.max_bin_side, input.max_bin_side);
-
-		std::optional<order_type> best_order;
+	auto find_best_order(
+		empty_spaces_type& root,
+		F& for_each_order,
+		const typename empty_spaces_type::rect_wh_type starting_bin,
+		const I& input
+	) {
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+		using area_type = search_area_t<empty_spaces_type, typename I::area_type>;
 
-		int best_total_inserted = -1;
-		auto best_bin = max_bin;
+		best_order_result<order_type, rect_wh_type, area_type> best;
+		best.bin = starting_bin;
 
-		/* 
-			The root node is re-used on the TLS. 
-			It is always reset before any packing attempt.
-		*/
+		const bool pruning = input.space_pruning == space_pruning_option::ENABLED;
+		const bool bounding = input.incumbent_bound == incumbent_bound_option::ENABLED;
+		std::vector<rect_wh_type> smallest_remaining;
 
-		thread_local empty_spaces_type root = rect_wh();
 		root.flipping_mode = input.flipping_mode;
+		root.merging_mode = input.space_merging;
 
 		for_each_order ([&](const order_type& current_order) {
-			const auto packing = best_packing_for_ordering(
+			if (pruning) {
+				find_smallest_remaining(smallest_remaining, current_order, input);
+			}
+
+			std::optional<area_type> incumbent_area;
+
+			if (bounding && best.found_bin) {
+				incumbent_area = area_as<area_type>(best.bin);
+			}
+
+			const auto packing = best_packing_for_ordering<area_type>(
 				root,
 				current_order,
-				max_bin,
-				input.discard_step
+				starting_bin,
+				input,
+				pruning ? smallest_remaining.data() : nullptr,
+				incumbent_area
 			);
 
-			if (const auto total_inserted = std::get_if<total_area_type>(&packing)) {
+			if (const auto total_inserted = std::get_if<area_type>(&packing)) {
 				/*
 					Track which function inserts the most area in total,
 					just in case that all orders will fail to fit into the largest allowed bin.
 				*/
-				if (!best_order.has_value()) {
-					if (*total_inserted > best_total_inserted) {
-						best_order = current_order;
-						best_total_inserted = *total_inserted;
+				if (!best.order.has_value()) {
+					if (*total_inserted > best.total_inserted) {
+						best.order = current_order;
+						best.total_inserted = *total_inserted;
 					}
 				}
 			}
-			else if (const auto result_bin = std::get_if<rect_wh>(&packing)) {
+			else if (const auto result_bin = std::get_if<rect_wh_type>(&packing)) {
 				/* Save the function if it performed the best. */
-				if (result_bin->area() <= best_bin.area()) {
-					best_order = current_order;
-					best_bin = *result_bin;
+				if (area_as<area_type>(*result_bin) <= area_as<area_type>(best.bin)) {
+					best.order = current_order;
+					best.bin = *result_bin;
+					best.found_bin = true;
 				}
 			}
 		});
 
-		assert(best_order.has_value());
-		
-		root.reset(best_bin);
+		return best;
+	}
 
-		for (auto& rr : *best_order) {
+	/*
+		Packs the order into the bin once more, this time writing the results to the rectangles.
+		The function reports which of the rectangles did and did not fit in the end.
+	*/
+
+	template <class empty_spaces_type, class O, class I>
+	auto write_packing(
+		empty_spaces_type& root,
+		const O& order,
+		const typename empty_spaces_type::rect_wh_type bin,
+		const I& input
+	) {
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+
+		const auto& constraint = input.bin_constraint;
+
+		/* Pruning never changes the placements, so this only saves time. */
+		const bool pruning = input.space_pruning == space_pruning_option::ENABLED;
+		std::vector<rect_wh_type> smallest_remaining;
+
+		if (pruning) {
+			find_smallest_remaining(smallest_remaining, order, input);
+		}
+
+		root.flipping_mode = input.flipping_mode;
+		root.merging_mode = input.space_merging;
+		root.reset(bin);
+
+		std::size_t position = 0;
+
+		for (auto& rr : order) {
 			auto& rect = dereference(rr).get_rect();
+			const auto original_size = rect.get_wh();
 
-			if (const auto ret = root.insert(rect.get_wh())) {
-				rect = *ret;
+			if (pruning) {
+				root.prune_spaces_below(smallest_remaining[position++]);
+			}
+
+			if (const auto ret = root.insert(constraint.align(original_size))) {
+				rect = with_size(*ret, original_size);
 
 				if (callback_result::ABORT_PACKING == input.handle_successful_insertion(rect)) {
 					break;
@@ -295,6 +566,32 @@ namespace rectpack2D {
 			}
 		}
 
-		return root.get_rects_aabb();
+		return constraint.round_up(root.get_rects_aabb());
+	}
+
+	/*
+		This function will try to find the best bin size among the ones generated by all provided rectangle orders.
+		Only the best order will have results written to.
+	*/
+
+	template <
+		class empty_spaces_type, 
+		class order_type,
+		class F,
+		class I
+	>
+	auto find_best_packing_impl(empty_spaces_type& root, F for_each_order, const I input) {
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+
+		const auto& constraint = input.bin_constraint;
+
+		/* The biggest legal bin. */
+		const auto max_bin = constraint.side_of(constraint.index_of(rect_wh_type(input.max_bin_side, input.max_bin_side)));
+
+		const auto best = find_best_order<empty_spaces_type, order_type>(root, for_each_order, max_bin, input);
+
+		assert(best.order.has_value());
+
+		return write_packing(root, *best.order, best.bin, input);
 	}
 }
@@ -0,0 +1,158 @@
+#pragma once
+#include "rect_structs.h"
+
+namespace rectpack2D {
+	enum class bin_size_rule {
+		ANY,
+		POWER_OF_TWO,
+		MULTIPLE_OF
+	};
+
+	/*
+		Restricts the bin sizes that the search will visit,
+		e.g. to power-of-two textures or ones aligned to 4x4 compression blocks (BC/ASTC).
+
+		The search then bisects over the legal sides only,
+		instead of converging to an arbitrary size that would have to be rounded up anyway.
+		This also takes far fewer trials - there are only a handful of powers of two below any max_bin_side.
+
+		To do this, the search works with indices of legal sides.
+		With bin_size_rule::ANY, the index of a side is just the side itself.
+	*/
+
+	struct bin_size_constraint {
+		bin_size_rule rule = bin_size_rule::ANY;
+
+		/* Used with bin_size_rule::MULTIPLE_OF, e.g. 4 for 4x4 blocks. */
+		int multiple = 1;
+
+		/*
+			If greater than 1, rectangles are inserted with both sides rounded up to a multiple of this value,
+			so that with a MULTIPLE_OF bin of the same multiple, every rectangle starts on the block grid.
+
+			The rectangles written back to you keep their original sizes.
+		*/
+		int rect_alignment = 1;
+
+		template <class T>
+		static constexpr T round_up_to_multiple(const T side, const T m) {
+			return (side + m - 1) / m * m;
+		}
+
+		template <class T>
+		constexpr T side_of(const T index) const {
+			if (rule == bin_size_rule::POWER_OF_TWO) {
+				return static_cast<T>(T(1) << index);
+			}
+
+			if (rule == bin_size_rule::MULTIPLE_OF) {
+				return static_cast<T>(index * multiple);
+			}
+
+			return index;
+		}
+
+		/* Index of the greatest legal side not bigger than the passed one. */
+
+		template <class T>
+		constexpr T index_of(const T side) const {
+			if (rule == bin_size_rule::POWER_OF_TWO) {
+				T index = 0;
+
+				/* Not (T(2) << index) <= side, which would overflow for sides of 2^30 and more. */
+				while ((T(1) << index) <= side / 2) {
+					++index;
+				}
+
+				return index;
+			}
+
+			if (rule == bin_size_rule::MULTIPLE_OF) {
+				return static_cast<T>(side / multiple);
+			}
+
+			return side;
+		}
+
+		/* The smallest legal side not smaller than the passed one. */
+
+		template <class T>
+		constexpr T round_up(const T side) const {
+			if (rule == bin_size_rule::POWER_OF_TWO) {
+				if (side <= 0) {
+					return side;
+				}
+
+				T result = 1;
+
+				while (result < side) {
+					result *= 2;
+				}
+
+				return result;
+			}
+
+			if (rule == bin_size_rule::MULTIPLE_OF) {
+				return round_up_to_multiple(side, static_cast<T>(multiple));
+			}
+
+			return side;
+		}
+
+		/* Translates discard_step from pixels to indices. */
+
+		constexpr int index_step(const int discard_step) const {
+			if (rule == bin_size_rule::POWER_OF_TWO) {
+				return 1;
+			}
+
+			if (rule == bin_size_rule::MULTIPLE_OF) {
+				return std::max(1, discard_step / multiple);
+			}
+
+			return discard_step;
+		}
+
+		template <class T>
+		constexpr auto side_of(const basic_rect_wh<T> index) const {
+			return basic_rect_wh<T>(side_of(index.w), side_of(index.h));
+		}
+
+		template <class T>
+		constexpr auto index_of(const basic_rect_wh<T> bin) const {
+			return basic_rect_wh<T>(index_of(bin.w), index_of(bin.h));
+		}
+
+		template <class T>
+		constexpr auto round_up(const basic_rect_wh<T> bin) const {
+			return basic_rect_wh<T>(round_up(bin.w), round_up(bin.h));
+		}
+
+		template <class T>
+		constexpr auto align(basic_rect_wh<T> r) const {
+			if (rect_alignment > 1) {
+				r.w = round_up_to_multiple(r.w, static_cast<T>(rect_alignment));
+				r.h = round_up_to_multiple(r.h, static_cast<T>(rect_alignment));
+			}
+
+			return r;
+		}
+	};
+
+	/* Gives a rectangle placed with bin_size_constraint::align its original size back. */
+
+	template <class T>
+	constexpr auto with_size(const basic_rect_xywh<T>& placed, const basic_rect_wh<T> size) {
+		return basic_rect_xywh<T>(placed.x, placed.y, size.w, size.h);
+	}
+
+	template <class T>
+	constexpr auto with_size(const basic_rect_xywhf<T>& placed, const basic_rect_wh<T> size) {
+		return basic_rect_xywhf<T>(placed.x, placed.y, size.w, size.h, placed.flipped);
+	}
+
+	template <class T>
+	constexpr auto with_size(const basic_compact_rect_xywhf<T>& placed, const basic_rect_wh<T> size) {
+		return basic_compact_rect_xywhf<T>(placed.x, placed.y, size.w, size.h, placed.flipped);
+	}
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <optional>
+#include <type_traits>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	/*
+		A flat binary format for packed layouts, to be loaded at startup without any parsing:
+		a binary_layout_header followed directly by the placements, in the order of the packed subjects.
+
+		The placements are stored exactly as output_rect_t<empty_spaces_type> is laid out in memory,
+		so a reader can map the file and index them in place.
+		The price is that a file is only readable on platforms with the same byte order and struct layout as the writer's -
+		the header records enough of both for view_binary_layout to refuse a file it can't read,
+		rather than return garbage.
+	*/
+
+	inline constexpr std::uint32_t binary_layout_version = 1;
+
+	template <class rect_type>
+	struct alignas(16) binary_layout_header {
+		using coord_type = typename rect_type::coord_type;
+
+		char magic[4] = { 'R', 'P', '2', 'L' };
+		std::uint32_t version = binary_layout_version;
+
+		/* Reads as 0x01020304 only with the byte order of the writer. */
+		std::uint32_t byte_order = 0x01020304;
+
+		std::uint32_t coord_size = sizeof(coord_type);
+		std::uint32_t rect_size = sizeof(rect_type);
+		std::uint32_t flippable = is_flippable_rect_v<rect_type>;
+
+		/* Whatever the writer passed, e.g. binary_layout_settings_hash of the finder_input. */
+		std::uint64_t settings_hash = 0;
+
+		std::uint64_t rect_count = 0;
+
+		basic_rect_wh<coord_type> bin;
+	};
+
+	/*
+		FNV-1a over every setting of the input that can change the layout,
+		so that a loader can tell that its layouts were packed with outdated settings.
+	*/
+
+	template <class F, class G, class A>
+	std::uint64_t binary_layout_settings_hash(const finder_input<F, G, A>& input) {
+		std::uint64_t hash = 14695981039346656037ull;
+
+		const auto mix = [&hash](const std::int64_t value) {
+			for (int byte = 0; byte < 8; ++byte) {
+				hash ^= static_cast<std::uint64_t>(value >> (byte * 8)) & 0xff;
+				hash *= 1099511628211ull;
+			}
+		};
+
+		mix(input.max_bin_side);
+		mix(input.discard_step);
+		mix(static_cast<std::int64_t>(input.flipping_mode));
+		mix(static_cast<std::int64_t>(input.bin_constraint.rule));
+		mix(input.bin_constraint.multiple);
+		mix(input.bin_constraint.rect_alignment);
+		mix(static_cast<std::int64_t>(input.space_pruning));
+		mix(static_cast<std::int64_t>(input.space_merging));
+		mix(static_cast<std::int64_t>(input.incumbent_bound));
+
+		return hash;
+	}
+
+	/*
+		Writes the bin returned by the finder and the rectangles of the subjects it has packed.
+		Rectangles that could not be placed are written as they were left.
+
+		The stream should be opened with std::ios::binary.
+		Returns false if writing failed.
+	*/
+
+	template <class empty_spaces_type, class Subjects>
+	bool write_binary_layout(
+		std::ostream& out,
+		const rect_wh_t<empty_spaces_type>& bin,
+		const Subjects& subjects,
+		const std::uint64_t settings_hash
+	) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+
+		static_assert(std::is_trivially_copyable_v<rect_type>);
+
+		binary_layout_header<rect_type> header;
+		header.settings_hash = settings_hash;
+		header.rect_count = static_cast<std::uint64_t>(std::size(subjects));
+		header.bin = bin;
+
+		/* Only the padding at the end of the header is left out, so that no garbage ends up in the file. */
+
+		char header_bytes[sizeof(header)] = {};
+		std::memcpy(header_bytes, &header, offsetof(decltype(header), bin) + sizeof(header.bin));
+
+		out.write(header_bytes, sizeof(header_bytes));
+
+		for (const auto& s : subjects) {
+			const rect_type& r = s.get_rect();
+			out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+		}
+
+		return out.good();
+	}
+
+	template <class rect_type>
+	class binary_layout_view {
+		const binary_layout_header<rect_type>* header;
+		const rect_type* rects;
+
+	public:
+		binary_layout_view(const binary_layout_header<rect_type>* const header_, const rect_type* const rects_) : header(header_), rects(rects_) {}
+
+		auto get_bin() const {
+			return header->bin;
+		}
+
+		std::uint64_t get_settings_hash() const {
+			return header->settings_hash;
+		}
+
+		std::size_t size() const {
+			return static_cast<std::size_t>(header->rect_count);
+		}
+
+		const rect_type& operator[](const std::size_t i) const {
+			return rects[i];
+		}
+
+		const rect_type* begin() const {
+			return rects;
+		}
+
+		const rect_type* end() const {
+			return rects + size();
+		}
+	};
+
+	/*
+		Views a layout in memory - e.g. a mapped file - without copying anything.
+		The memory must stay alive as long as the view, and be aligned to 16 bytes, which mapped files always are.
+
+		Returns std::nullopt if the memory does not hold a complete layout of rect_type
+		written by a platform with the same byte order and struct layout.
+	*/
+
+	template <class rect_type>
+	std::optional<binary_layout_view<rect_type>> view_binary_layout(const void* const data, const std::size_t size) {
+		using header_type = binary_layout_header<rect_type>;
+
+		if (size < sizeof(header_type) || reinterpret_cast<std::uintptr_t>(data) % alignof(header_type) != 0) {
+			return std::nullopt;
+		}
+
+		const auto header = static_cast<const header_type*>(data);
+		const header_type expected;
+
+		if (
+			std::memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0
+			|| header->version != expected.version
+			|| header->byte_order != expected.byte_order
+			|| header->coord_size != expected.coord_size
+			|| header->rect_size != expected.rect_size
+			|| header->flippable != expected.flippable
+		) {
+			return std::nullopt;
+		}
+
+		if (header->rect_count > (size - sizeof(header_type)) / sizeof(rect_type)) {
+			return std::nullopt;
+		}
+
+		const auto rects = reinterpret_cast<const rect_type*>(static_cast<const char*>(data) + sizeof(header_type));
+		return binary_layout_view<rect_type>(header, rects);
+	}
+}
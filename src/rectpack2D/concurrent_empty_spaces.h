@@ -0,0 +1,193 @@
+#pragma once
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "empty_spaces.h"
+#include "empty_space_allocators.h"
+
+namespace rectpack2D {
+	/*
+		A shared bin that several threads can insert into at the same time,
+		e.g. loader threads reserving regions of one atlas.
+
+		The bin is split into a grid of shards, each a separate empty_spaces behind its own mutex.
+		A thread inserts into its home shard first (picked from its thread id, unless a shard is passed explicitly),
+		then into whichever other shard it can lock without waiting,
+		and only then waits for the remaining shards in turn.
+		Threads working on different shards never contend,
+		so with at least as many shards as threads, most insertions take no contended lock at all.
+
+		The price is density: a rectangle can never straddle two shards,
+		and no rectangle bigger than a shard fits at all - choose shard_count accordingly.
+		shard_count is clamped to between 1 and max_shards.
+	*/
+
+	template <bool allow_flip, class empty_spaces_provider = default_empty_spaces, class selection_policy = last_fit>
+	class concurrent_empty_spaces {
+		using shard_spaces_type = empty_spaces<allow_flip, empty_spaces_provider, selection_policy>;
+
+	public:
+		/* The shards that were busy are remembered in the bits of a std::uint64_t. */
+		static constexpr std::size_t max_shards = 64;
+
+		using coord_type = typename shard_spaces_type::coord_type;
+		using rect_wh_type = typename shard_spaces_type::rect_wh_type;
+		using output_rect_type = typename shard_spaces_type::output_rect_type;
+
+	private:
+		struct shard {
+			std::mutex lock;
+			basic_rect_xywh<coord_type> region;
+			shard_spaces_type spaces;
+
+			shard(const basic_rect_xywh<coord_type>& region_) : region(region_), spaces(region_.get_wh()) {}
+		};
+
+		/* Mutexes can't be moved, hence the pointers. */
+		std::vector<std::unique_ptr<shard>> shards;
+
+		std::optional<output_rect_type> insert_locked(shard& s, const rect_wh_type& image_rectangle) {
+			auto result = s.spaces.insert(image_rectangle);
+
+			if (result) {
+				result->x = static_cast<coord_type>(result->x + s.region.x);
+				result->y = static_cast<coord_type>(result->y + s.region.y);
+			}
+
+			return result;
+		}
+
+	public:
+		concurrent_empty_spaces(
+			const rect_wh_type& bin,
+			const std::size_t requested_shard_count = std::thread::hardware_concurrency(),
+			const flipping_option flipping_mode = flipping_option::ENABLED
+		) {
+			const auto shard_count = std::clamp(requested_shard_count, std::size_t(1), max_shards);
+
+			/* The grid closest to a square that has exactly shard_count cells. */
+
+			std::size_t columns = 1;
+
+			for (std::size_t c = 1; c * c <= shard_count; ++c) {
+				if (shard_count % c == 0) {
+					columns = c;
+				}
+			}
+
+			if (bin.w < bin.h) {
+				columns = shard_count / columns;
+			}
+
+			const auto rows = shard_count / columns;
+
+			for (std::size_t i = 0; i < shard_count; ++i) {
+				const auto column = i % columns;
+				const auto row = i / columns;
+
+				const auto x = static_cast<coord_type>(bin.w * column / columns);
+				const auto y = static_cast<coord_type>(bin.h * row / rows);
+				const auto next_x = static_cast<coord_type>(bin.w * (column + 1) / columns);
+				const auto next_y = static_cast<coord_type>(bin.h * (row + 1) / rows);
+
+				shards.emplace_back(std::make_unique<shard>(basic_rect_xywh<coord_type>(x, y, next_x - x, next_y - y)));
+				shards.back()->spaces.flipping_mode = flipping_mode;
+			}
+		}
+
+		std::size_t get_shard_count() const {
+			return shards.size();
+		}
+
+		auto get_shard_region(const std::size_t i) const {
+			return shards[i]->region;
+		}
+
+		std::size_t home_shard() const {
+			return std::hash<std::thread::id>()(std::this_thread::get_id()) % shards.size();
+		}
+
+		/* Thread-safe. Returns the placement in the coordinates of the whole bin. */
+
+		std::optional<output_rect_type> insert(const rect_wh_type& image_rectangle, const std::size_t preferred_shard) {
+			const auto n = shards.size();
+
+			{
+				auto& home = *shards[preferred_shard % n];
+				std::lock_guard<std::mutex> guard(home.lock);
+
+				if (const auto result = insert_locked(home, image_rectangle)) {
+					return result;
+				}
+			}
+
+			/* First take whatever is free right now... */
+
+			std::uint64_t busy = 0;
+
+			for (std::size_t k = 1; k < n; ++k) {
+				auto& other = *shards[(preferred_shard + k) % n];
+				std::unique_lock<std::mutex> guard(other.lock, std::try_to_lock);
+
+				if (!guard.owns_lock()) {
+					busy |= std::uint64_t(1) << k;
+					continue;
+				}
+
+				if (const auto result = insert_locked(other, image_rectangle)) {
+					return result;
+				}
+			}
+
+			/* ...and only then wait for the shards that were busy. */
+
+			for (std::size_t k = 1; k < n && busy != 0; ++k) {
+				if ((busy & (std::uint64_t(1) << k)) == 0) {
+					continue;
+				}
+
+				auto& other = *shards[(preferred_shard + k) % n];
+				std::lock_guard<std::mutex> guard(other.lock);
+
+				if (const auto result = insert_locked(other, image_rectangle)) {
+					return result;
+				}
+			}
+
+			return std::nullopt;
+		}
+
+		std::optional<output_rect_type> insert(const rect_wh_type& image_rectangle) {
+			return insert(image_rectangle, home_shard());
+		}
+
+		/* Not thread-safe. */
+
+		void reset() {
+			for (auto& s : shards) {
+				s->spaces.reset(s->region.get_wh());
+			}
+		}
+
+		/* Thread-safe, but only a snapshot if insertions are still running. */
+
+		auto get_rects_aabb() {
+			rect_wh_type aabb;
+
+			for (auto& s : shards) {
+				std::lock_guard<std::mutex> guard(s->lock);
+				const auto shard_aabb = s->spaces.get_rects_aabb();
+
+				if (shard_aabb.w > 0 && shard_aabb.h > 0) {
+					aabb.expand_with(basic_rect_xywh<coord_type>(s->region.x, s->region.y, shard_aabb.w, shard_aabb.h));
+				}
+			}
+
+			return aabb;
+		}
+	};
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	template <class empty_spaces_type, std::size_t N>
+	struct constexpr_packing {
+		rect_wh_t<empty_spaces_type> bin;
+
+		/* In the order of the passed sizes. */
+		std::array<output_rect_t<empty_spaces_type>, N> rects;
+	};
+
+	/* std::sort is not constexpr until C++20. */
+
+	template <class T, std::size_t N, class Less>
+	constexpr void insertion_sort(std::array<T, N>& elements, const std::size_t count, Less less) {
+		for (std::size_t i = 1; i < count; ++i) {
+			const auto moved = elements[i];
+			auto j = i;
+
+			for (; j > 0 && less(moved, elements[j - 1]); --j) {
+				elements[j] = elements[j - 1];
+			}
+
+			elements[j] = moved;
+		}
+	}
+
+	/*
+		Same as find_best_packing with the default comparators, but usable in constant expressions,
+		so that atlases known at build time cost nothing at startup:
+
+			constexpr auto atlas = find_best_packing_constexpr<spaces_type>(sizes, input);
+
+		The empty_spaces_type must use static_empty_spaces, and the callbacks of the input must be constexpr-callable -
+		e.g. lambdas that just return callback_result::CONTINUE_PACKING.
+		space_pruning is ignored, and stats must be null.
+
+		The orders are sorted with a stable insertion sort,
+		so rectangles comparing equal might be ordered - and thus placed - differently than by find_best_packing at runtime.
+		Mind the constexpr evaluation limits of your compiler for bigger inputs,
+		e.g. -fconstexpr-ops-limit on GCC or -fconstexpr-steps on Clang.
+	*/
+
+	template <class empty_spaces_type, std::size_t N, class F, class G, class A>
+	constexpr auto find_best_packing_constexpr(
+		const std::array<rect_wh_t<empty_spaces_type>, N>& sizes,
+		const finder_input<F, G, A>& input
+	) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+		using rect_wh_type = rect_wh_t<empty_spaces_type>;
+		using area_type = search_area_t<empty_spaces_type, A>;
+		using order_type = rectpack2D::span<rect_type* const*>;
+
+		constexpr std::size_t count_orders = with_default_comparators<empty_spaces_type, area_type>(
+			[](auto... comparators) { return sizeof...(comparators); }
+		);
+
+		constexpr_packing<empty_spaces_type, N> result {};
+
+		for (std::size_t i = 0; i < N; ++i) {
+			result.rects[i].w = sizes[i].w;
+			result.rects[i].h = sizes[i].h;
+		}
+
+		std::array<std::array<rect_type*, N>, count_orders> orders {};
+		std::size_t count_valid = 0;
+
+		for (auto& r : result.rects) {
+			if (area_as<area_type>(r) != 0) {
+				orders[0][count_valid++] = &r;
+			}
+		}
+
+		with_default_comparators<empty_spaces_type, area_type>([&orders, count_valid](auto... comparators) {
+			std::size_t k = 0;
+
+			((orders[k] = orders[0], insertion_sort(orders[k], count_valid, comparators), ++k), ...);
+		});
+
+		const auto& constraint = input.bin_constraint;
+		const auto max_bin = constraint.side_of(constraint.index_of(rect_wh_type(input.max_bin_side, input.max_bin_side)));
+
+		empty_spaces_type root { rect_wh_type() };
+		root.flipping_mode = input.flipping_mode;
+		root.merging_mode = input.space_merging;
+
+		/* Picks the best order exactly like find_best_order. */
+
+		const bool bounding = input.incumbent_bound == incumbent_bound_option::ENABLED;
+
+		std::size_t best_order = count_orders;
+		rect_wh_type best_bin = max_bin;
+		bool found_bin = false;
+		area_type best_total_inserted = -1;
+
+		for (std::size_t k = 0; k < count_orders; ++k) {
+			const auto current_order = order_type(orders[k].data(), orders[k].data() + count_valid);
+
+			const auto incumbent_area = bounding && found_bin 
+				? std::optional<area_type>(area_as<area_type>(best_bin)) 
+				: std::optional<area_type>()
+			;
+
+			const auto packing = best_packing_for_ordering<area_type>(root, current_order, max_bin, input, nullptr, incumbent_area);
+
+			if (const auto total_inserted = std::get_if<area_type>(&packing)) {
+				if (best_order == count_orders && *total_inserted > best_total_inserted) {
+					best_order = k;
+					best_total_inserted = *total_inserted;
+				}
+			}
+			else if (const auto result_bin = std::get_if<rect_wh_type>(&packing)) {
+				if (area_as<area_type>(*result_bin) <= area_as<area_type>(best_bin)) {
+					best_order = k;
+					best_bin = *result_bin;
+					found_bin = true;
+				}
+			}
+		}
+
+		/* Writes the results exactly like write_packing. */
+
+		root.reset(best_bin);
+
+		for (std::size_t i = 0; i < count_valid; ++i) {
+			auto& rect = *orders[best_order][i];
+			const auto original_size = rect.get_wh();
+
+			if (const auto ret = root.insert(constraint.align(original_size))) {
+				rect = with_size(*ret, original_size);
+
+				if (callback_result::ABORT_PACKING == input.handle_successful_insertion(rect)) {
+					break;
+				}
+			}
+			else {
+				if (callback_result::ABORT_PACKING == input.handle_unsuccessful_insertion(rect)) {
+					break;
+				}
+			}
+		}
+
+		result.bin = constraint.round_up(root.get_rects_aabb());
+		return result;
+	}
+
+#if defined(__cpp_consteval)
+	/*
+		Guarantees that the packing happens at compile time.
+		The input has to be a constant expression, e.g. made with make_finder_input in a constexpr variable.
+	*/
+
+	template <class empty_spaces_type, std::size_t N, class F, class G, class A>
+	consteval auto pack_at_compile_time(
+		const std::array<rect_wh_t<empty_spaces_type>, N>& sizes,
+		const finder_input<F, G, A>& input
+	) {
+		return find_best_packing_constexpr<empty_spaces_type>(sizes, input);
+	}
+#endif
+}
@@ -1,13 +1,76 @@
 #pragma once
 #include <array>
 #include <vector>
+#include <memory_resource>
 #include "rect_structs.h"
 
 namespace rectpack2D {
-	class default_empty_spaces {
+	/*
+		Every provider is templated on the coordinate type of the spaces it stores (see rect_structs.h),
+		and empty_spaces takes its coordinate type from the provider.
+
+		A provider of your own needs remove (moving the last space in place of the removed one), add, get_count, reset and get.
+		Space pruning (see empty_spaces::prune_spaces_below) also needs get to have a non-const overload returning a reference.
+	*/
+
+	template <class T>
+	class basic_default_empty_spaces {
+		using space_rect = basic_rect_xywh<T>;
 		std::vector<space_rect> empty_spaces;
 
 	public:
+		using coord_type = T;
+
+		void remove(const int i) {
+			empty_spaces[i] = empty_spaces.back();
+			empty_spaces.pop_back();
+		}
+
+		bool add(const space_rect r) {
+			empty_spaces.emplace_back(r);
+			return true;
+		}
+
+		auto get_count() const {
+			return empty_spaces.size();
+		}
+
+		void reset() {
+			empty_spaces.clear();
+		}
+
+		const auto& get(const int i) const {
+			return empty_spaces[i];
+		}
+
+		auto& get(const int i) {
+			return empty_spaces[i];
+		}
+	};
+
+	/*
+		Same as default_empty_spaces, but the storage comes from a caller-provided std::pmr::memory_resource,
+		e.g. a monotonic_buffer_resource over a stack buffer.
+
+		Reserve enough spaces up front if the resource cannot reclaim memory,
+		so that the vector never needs to grow.
+	*/
+
+	template <class T>
+	class basic_pmr_empty_spaces {
+		using space_rect = basic_rect_xywh<T>;
+		std::pmr::vector<space_rect> empty_spaces;
+
+	public:
+		using coord_type = T;
+
+		basic_pmr_empty_spaces(
+			std::pmr::memory_resource* const resource = std::pmr::get_default_resource(),
+			const std::size_t reserved_spaces = 0
+		) : empty_spaces(resource) {
+			empty_spaces.reserve(reserved_spaces);
+		}
+
 		void remove(const int i) {
 			empty_spaces[i] = empty_spaces.back();
 			empty_spaces.pop_back();
@@ -26,23 +89,40 @@ namespace rectpack2D {
 			empty_spaces.clear();
 		}
 
-		const auto& get(const int i) {
+		const auto& get(const int i) const {
+			return empty_spaces[i];
+		}
+
+		auto& get(const int i) {
 			return empty_spaces[i];
 		}
 	};
 
-	template <int MAX_SPACES>
+	using default_empty_spaces = basic_default_empty_spaces<int>;
+	using pmr_empty_spaces = basic_pmr_empty_spaces<int>;
+
+	/*
+		Note: when static_empty_spaces runs out of space, empty_spaces::insert fails
+		in the middle of splitting, and the space being split is lost.
+		Use small_empty_spaces below if the upper bound is not known for certain.
+	*/
+
+	template <int MAX_SPACES, class T = int>
 	class static_empty_spaces {
+		using space_rect = basic_rect_xywh<T>;
+
 		int count_spaces = 0;
-		std::array<space_rect, MAX_SPACES> empty_spaces;
+		std::array<space_rect, MAX_SPACES> empty_spaces {};
 
 	public:
-		void remove(const int i) {
+		using coord_type = T;
+
+		constexpr void remove(const int i) {
 			empty_spaces[i] = empty_spaces[count_spaces - 1];
 			--count_spaces;
 		}
 
-		bool add(const space_rect r) {
+		constexpr bool add(const space_rect r) {
 			if (count_spaces < static_cast<int>(empty_spaces.size())) {
 				empty_spaces[count_spaces] = r;
 				++count_spaces;
@@ -53,16 +133,94 @@ namespace rectpack2D {
 			return false;
 		}
 		
+		constexpr auto get_count() const {
+			return count_spaces;
+		}
+
+		constexpr void reset() {
+			count_spaces = 0;
+		}
+
+		constexpr const auto& get(const int i) const {
+			return empty_spaces[i];
+		}
+
+		constexpr auto& get(const int i) {
+			return empty_spaces[i];
+		}
+	};
+
+	/*
+		Keeps the first INLINE_SPACES spaces in an array, just like static_empty_spaces,
+		but spills the rest to the heap instead of failing.
+
+		The spaces are ordered exactly as in the other providers,
+		so the resultant packings are identical.
+	*/
+
+	template <int INLINE_SPACES, class T = int>
+	class small_empty_spaces {
+		using space_rect = basic_rect_xywh<T>;
+
+		int count_spaces = 0;
+		std::array<space_rect, INLINE_SPACES> inline_spaces;
+		std::vector<space_rect> spilled_spaces;
+
+		auto& at(const int i) {
+			if (i < INLINE_SPACES) {
+				return inline_spaces[i];
+			}
+
+			return spilled_spaces[i - INLINE_SPACES];
+		}
+
+		const auto& at(const int i) const {
+			if (i < INLINE_SPACES) {
+				return inline_spaces[i];
+			}
+
+			return spilled_spaces[i - INLINE_SPACES];
+		}
+
+	public:
+		using coord_type = T;
+
+		void remove(const int i) {
+			at(i) = at(count_spaces - 1);
+			--count_spaces;
+
+			if (count_spaces >= INLINE_SPACES) {
+				spilled_spaces.pop_back();
+			}
+		}
+
+		bool add(const space_rect r) {
+			if (count_spaces < INLINE_SPACES) {
+				inline_spaces[count_spaces] = r;
+			}
+			else {
+				spilled_spaces.emplace_back(r);
+			}
+
+			++count_spaces;
+			return true;
+		}
+
 		auto get_count() const {
 			return count_spaces;
 		}
 
 		void reset() {
 			count_spaces = 0;
+			spilled_spaces.clear();
 		}
 
-		const auto& get(const int i) {
-			return empty_spaces[i];
+		const auto& get(const int i) const {
+			return at(i);
+		}
+
+		auto& get(const int i) {
+			return at(i);
 		}
 	};
 }
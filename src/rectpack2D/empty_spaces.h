@@ -1,6 +1,11 @@
 #pragma once
+#include <array>
+#include <limits>
+#include <cstdint>
 #include <optional>
+#include <type_traits>
 #include "insert_and_split.h"
+#include "space_selection.h"
 
 namespace rectpack2D {
 	enum class flipping_option {
@@ -8,98 +13,358 @@ namespace rectpack2D {
 		ENABLED
 	};
 
-	class default_empty_spaces;
+	/*
+		Guillotine splits never rejoin on their own,
+		so over thousands of insertions the list fills up with neighbouring spaces
+		that could just as well be a single one.
 
-	template <bool allow_flip, class empty_spaces_provider = default_empty_spaces>
+		AMORTIZED merges the whole list (see empty_spaces::merge_spaces)
+		once it has grown twice as long as after the previous merge,
+		which costs O(log n) per insertion on average.
+		Like pruning, it does nothing with a provider whose get can't modify the spaces.
+		It is still slower than DISABLED and changes the bin by about a percent either way,
+		so leave it off unless the bins of your workload come out smaller with it.
+	*/
+
+	enum class space_merging_option {
+		DISABLED,
+		AMORTIZED
+	};
+
+	template <class T>
+	class basic_default_empty_spaces;
+
+	/* Whether spaces can be modified in place through get, which space pruning needs. */
+
+	template <class P, class = void>
+	struct has_mutable_spaces : std::false_type {};
+
+	template <class P>
+	struct has_mutable_spaces<P, std::void_t<decltype(std::declval<P&>().get(0).w = 0)>> : std::true_type {};
+
+	using default_empty_spaces = basic_default_empty_spaces<int>;
+
+	/*
+		flipped_rect is the rectangle written for a placement when allow_flip is set,
+		e.g. basic_compact_rect_xywhf to pack the flipped flag into the height.
+	*/
+
+	template <
+		bool allow_flip,
+		class empty_spaces_provider = default_empty_spaces,
+		class selection_policy = last_fit,
+		template <class> class flipped_rect = basic_rect_xywhf
+	>
 	class empty_spaces {
-		rect_wh current_aabb;
+	public:
+		using coord_type = typename empty_spaces_provider::coord_type;
+		using rect_wh_type = basic_rect_wh<coord_type>;
+		using output_rect_type = std::conditional_t<allow_flip, flipped_rect<coord_type>, basic_rect_xywh<coord_type>>;
+
+	private:
+		static constexpr bool can_prune = has_mutable_spaces<empty_spaces_provider>::value;
+
+		rect_wh_type current_aabb;
+		rect_wh_type prune_below;
+		std::size_t count_after_merge = 0;
 		empty_spaces_provider spaces;
 
 		/* MSVC fix for non-conformant if constexpr implementation */
 
-		static auto make_output_rect(const int x, const int y, const int w, const int h) {
-			return rect_xywh(x, y, w, h);
+		static constexpr auto make_output_rect(const coord_type x, const coord_type y, const coord_type w, const coord_type h) {
+			return basic_rect_xywh<coord_type>(x, y, w, h);
+		}
+
+		static constexpr auto make_output_rect(const coord_type x, const coord_type y, const coord_type w, const coord_type h, const bool flipped) {
+			return flipped_rect<coord_type>(x, y, w, h, flipped);
+		}
+
+		template <class P = selection_policy>
+		static constexpr auto best_score_of(const basic_rect_xywh<coord_type>& space, const rect_wh_type& im) {
+			if constexpr(P::first_fit) {
+				(void)space;
+				(void)im;
+
+				return 0;
+			}
+			else {
+				return P::score(space, im);
+			}
+		}
+
+		/*
+			Pruned spaces are not removed, as that would move the last space in their place,
+			changing the order of the scan and thus the placements.
+			They are turned into tombstones in place instead:
+			w is negative, and h is the number of tombstones in a row, from this one down, that the scan can jump over at once.
+		*/
+
+		static constexpr bool is_tombstone(const basic_rect_xywh<coord_type>& space) {
+			return space.w < 0;
+		}
+
+		/* Returns how many tombstones to jump over from the one at index i, joining the runs right below it. */
+
+		constexpr int skip_tombstones(const int i) {
+			constexpr auto max_skip = static_cast<int>(std::min<std::int64_t>(
+				std::numeric_limits<coord_type>::max(),
+				std::numeric_limits<int>::max()
+			));
+
+			auto& head = spaces.get(i);
+			auto skip = static_cast<int>(head.h);
+
+			while (i - skip >= 0) {
+				const auto& below = spaces.get(i - skip);
+
+				if (!is_tombstone(below) || below.h > max_skip - skip) {
+					break;
+				}
+
+				skip += below.h;
+			}
+
+			head.h = static_cast<coord_type>(skip);
+			return skip;
+		}
+
+		constexpr void remove_tombstones() {
+			if constexpr(can_prune) {
+				for (int i = static_cast<int>(spaces.get_count()) - 1; i >= 0; --i) {
+					if (is_tombstone(spaces.get(i))) {
+						spaces.remove(i);
+					}
+				}
+			}
+		}
+
+		/*
+			Spaces that share a full edge are found by sorting the list by that edge,
+			which puts every space right after the one it continues:
+			by x, w and then y for the ones stacked vertically, by y, h and then x for the ones side by side.
+			The list is heap-sorted in place, so that no memory is needed beyond the provider's.
+		*/
+
+		template <bool vertical>
+		static constexpr bool edge_less(const basic_rect_xywh<coord_type>& a, const basic_rect_xywh<coord_type>& b) {
+			if constexpr(vertical) {
+				if (a.x != b.x) return a.x < b.x;
+				if (a.w != b.w) return a.w < b.w;
+				return a.y < b.y;
+			}
+			else {
+				if (a.y != b.y) return a.y < b.y;
+				if (a.h != b.h) return a.h < b.h;
+				return a.x < b.x;
+			}
 		}
 
-		static auto make_output_rect(const int x, const int y, const int w, const int h, const bool flipped) {
-			return rect_xywhf(x, y, w, h, flipped);
+		template <bool vertical>
+		constexpr void sift_down(int root, const int count) {
+			for (;;) {
+				auto child = 2 * root + 1;
+
+				if (child >= count) {
+					return;
+				}
+
+				if (child + 1 < count && edge_less<vertical>(spaces.get(child), spaces.get(child + 1))) {
+					++child;
+				}
+
+				if (!edge_less<vertical>(spaces.get(root), spaces.get(child))) {
+					return;
+				}
+
+				const auto moved = spaces.get(root);
+				spaces.get(root) = spaces.get(child);
+				spaces.get(child) = moved;
+
+				root = child;
+			}
+		}
+
+		/* Merges every run of spaces continuing one another along the axis. Returns the number of merges. */
+
+		template <bool vertical>
+		constexpr int merge_along() {
+			const auto count = static_cast<int>(spaces.get_count());
+
+			for (int i = count / 2 - 1; i >= 0; --i) {
+				sift_down<vertical>(i, count);
+			}
+
+			for (int end = count - 1; end > 0; --end) {
+				const auto largest = spaces.get(0);
+				spaces.get(0) = spaces.get(end);
+				spaces.get(end) = largest;
+
+				sift_down<vertical>(0, end);
+			}
+
+			int kept = 0;
+
+			for (int i = 0; i < count; ++i) {
+				const auto next = spaces.get(i);
+
+				if (kept > 0) {
+					auto& last = spaces.get(kept - 1);
+
+					if constexpr(vertical) {
+						if (last.x == next.x && last.w == next.w && last.y + last.h == next.y) {
+							last.h = static_cast<coord_type>(last.h + next.h);
+							continue;
+						}
+					}
+					else {
+						if (last.y == next.y && last.h == next.h && last.x + last.w == next.x) {
+							last.w = static_cast<coord_type>(last.w + next.w);
+							continue;
+						}
+					}
+				}
+
+				spaces.get(kept++) = next;
+			}
+
+			/* Removing the last space just drops it. */
+
+			for (int i = count - 1; i >= kept; --i) {
+				spaces.remove(i);
+			}
+
+			return count - kept;
+		}
+
+		constexpr void merge_after_insertion() {
+			if constexpr(can_prune) {
+				if (merging_mode == space_merging_option::AMORTIZED) {
+					if (static_cast<std::size_t>(spaces.get_count()) >= 2 * std::max(count_after_merge, std::size_t(16))) {
+						merge_spaces();
+					}
+				}
+			}
 		}
 
 	public:
-		using output_rect_type = std::conditional_t<allow_flip, rect_xywhf, rect_xywh>;
 
 		flipping_option flipping_mode = flipping_option::ENABLED;
+		space_merging_option merging_mode = space_merging_option::DISABLED;
+
+		/* Any additional arguments are forwarded to the constructor of the provider. */
 
-		empty_spaces(const rect_wh& r) {
+		template <class... ProviderArgs>
+		constexpr empty_spaces(const rect_wh_type& r, ProviderArgs&&... provider_args) : spaces(std::forward<ProviderArgs>(provider_args)...) {
 			reset(r);
 		}
 
-		void reset(const rect_wh& r) {
+		constexpr void reset(const rect_wh_type& r) {
 			current_aabb = {};
+			prune_below = {};
+			count_after_merge = 0;
 
 			spaces.reset();
-			spaces.add(rect_xywh(0, 0, r.w, r.h));
+			spaces.add(basic_rect_xywh<coord_type>(0, 0, r.w, r.h));
 		}
 
 		template <class F>
-		std::optional<output_rect_type> insert(const rect_wh image_rectangle, F report_candidate_empty_space) {
+		constexpr std::optional<output_rect_type> insert(const rect_wh_type image_rectangle, F report_candidate_empty_space) {
+			using splits_type = basic_created_splits<coord_type>;
+
+			/* Only used by the policies that look for the best of several spaces. */
+
+			int best_index = -1;
+			int examined_after_fit = 0;
+			splits_type best_splits;
+			bool best_flipped = false;
+			decltype(best_score_of(std::declval<basic_rect_xywh<coord_type>>(), image_rectangle)) best_score{};
+
+			/* Merging removes spaces from anywhere, which would break the runs of tombstones. */
+			const bool pruning = merging_mode == space_merging_option::DISABLED && (prune_below.w > 0 || prune_below.h > 0);
+
 			for (int i = static_cast<int>(spaces.get_count()) - 1; i >= 0; --i) {
-				const auto candidate_space = spaces.get(i);
+				if constexpr(can_prune) {
+					if (pruning) {
+						auto& space = spaces.get(i);
 
-				report_candidate_empty_space(candidate_space);
+						if (!is_tombstone(space) && (space.w < prune_below.w || space.h < prune_below.h)) {
+							/* Nothing will ever fit here anymore. */
 
-				auto accept_result = [this, i, image_rectangle, candidate_space](
-					const created_splits& splits,
-					const bool flipping_necessary
-				) -> std::optional<output_rect_type> {
-					spaces.remove(i);
+							space.w = -1;
+							space.h = 1;
+						}
 
-					for (int s = 0; s < splits.count; ++s) {
-						if (!spaces.add(splits.spaces[s])) {
-							return std::nullopt;
+						if (is_tombstone(space)) {
+							const int skipped = skip_tombstones(i);
+
+							/* Counted exactly as if every skipped space had been examined and did not fit. */
+
+							if constexpr(!selection_policy::first_fit) {
+								if (selection_policy::max_candidates > 0 && best_index != -1) {
+									if (examined_after_fit + skipped > selection_policy::max_candidates) {
+										break;
+									}
+
+									examined_after_fit += skipped;
+								}
+							}
+
+							i -= skipped - 1;
+							continue;
 						}
 					}
+				}
+
+				const auto candidate_space = spaces.get(i);
+
+				if constexpr(!selection_policy::first_fit) {
+					if (selection_policy::max_candidates > 0 && best_index != -1 && examined_after_fit++ == selection_policy::max_candidates) {
+						break;
+					}
+				}
+
+				report_candidate_empty_space(candidate_space);
 
-					if constexpr(allow_flip) {
-						const auto result = make_output_rect(
-							candidate_space.x,
-							candidate_space.y,
-							image_rectangle.w,
-							image_rectangle.h,
-							flipping_necessary
-						);
-
-						current_aabb.expand_with(result);
-						return result;
+				/* Returns true if the scan should stop. */
+
+				auto consider = [&](const splits_type& splits, const bool flipping_necessary) {
+					if constexpr(selection_policy::first_fit) {
+						best_index = i;
+						best_splits = splits;
+						best_flipped = flipping_necessary;
+
+						return true;
 					}
-					else if constexpr(!allow_flip) {
-						(void)flipping_necessary;
-
-						const auto result = make_output_rect(
-							candidate_space.x,
-							candidate_space.y,
-							image_rectangle.w,
-							image_rectangle.h
-						);
-
-						current_aabb.expand_with(result);
-						return result;
+					else {
+						const auto placed = flipping_necessary ? rect_wh_type(image_rectangle).flip() : image_rectangle;
+						const auto score = best_score_of(candidate_space, placed);
+
+						if (best_index == -1 || score < best_score) {
+							best_index = i;
+							best_splits = splits;
+							best_flipped = flipping_necessary;
+							best_score = score;
+						}
+
+						return false;
 					}
 				};
 
-				auto try_to_insert = [&](const rect_wh& img) {
+				auto try_to_insert = [&](const rect_wh_type& img) {
 					return rectpack2D::insert_and_split(img, candidate_space);
 				};
 
 				if constexpr(!allow_flip) {
 					if (const auto normal = try_to_insert(image_rectangle)) {
-						return accept_result(normal, false);
+						if (consider(normal, false)) {
+							break;
+						}
 					}
 				}
 				else {
 					if (flipping_mode == flipping_option::ENABLED) {
 						const auto normal = try_to_insert(image_rectangle);
-						const auto flipped = try_to_insert(rect_wh(image_rectangle).flip());
+						const auto flipped = try_to_insert(rect_wh_type(image_rectangle).flip());
 
 						/* 
 							If both were successful, 
@@ -107,43 +372,148 @@ namespace rectpack2D {
 						*/
 
 						if (normal && flipped) {
-							if (flipped.better_than(normal)) {
-								/* Accept the flipped result if it producues less or "better" spaces. */
+							if constexpr(selection_policy::first_fit) {
+								if (flipped.better_than(normal)) {
+									/* Accept the flipped result if it producues less or "better" spaces. */
 
-								return accept_result(flipped, true);
+									consider(flipped, true);
+									break;
+								}
+
+								consider(normal, false);
+								break;
 							}
+							else {
+								/* Let the policy score both orientations. */
 
-							return accept_result(normal, false);
+								if (consider(normal, false) || consider(flipped, true)) {
+									break;
+								}
+							}
 						}
-
-						if (normal) {
-							return accept_result(normal, false);
+						else if (normal) {
+							if (consider(normal, false)) {
+								break;
+							}
 						}
-
-						if (flipped) {
-							return accept_result(flipped, true);
+						else if (flipped) {
+							if (consider(flipped, true)) {
+								break;
+							}
 						}
 					}
 					else {
 						if (const auto normal = try_to_insert(image_rectangle)) {
-							return accept_result(normal, false);
+							if (consider(normal, false)) {
+								break;
+							}
 						}
 					}
 				}
 			}
 
-			return std::nullopt;
+			if (best_index == -1) {
+				return std::nullopt;
+			}
+
+			const auto chosen_space = spaces.get(best_index);
+
+			spaces.remove(best_index);
+
+			if constexpr(can_prune) {
+				/* A tombstone moved here from the end, so the tombstones below are not its own. */
+
+				if (best_index < static_cast<int>(spaces.get_count()) && is_tombstone(spaces.get(best_index))) {
+					spaces.get(best_index).h = 1;
+				}
+			}
+
+			for (int s = 0; s < best_splits.count; ++s) {
+				if (!spaces.add(best_splits.spaces[s])) {
+					return std::nullopt;
+				}
+			}
+
+			merge_after_insertion();
+
+			if constexpr(allow_flip) {
+				const auto result = make_output_rect(
+					chosen_space.x,
+					chosen_space.y,
+					image_rectangle.w,
+					image_rectangle.h,
+					best_flipped
+				);
+
+				current_aabb.expand_with(result);
+				return result;
+			}
+			else if constexpr(!allow_flip) {
+				(void)best_flipped;
+
+				const auto result = make_output_rect(
+					chosen_space.x,
+					chosen_space.y,
+					image_rectangle.w,
+					image_rectangle.h
+				);
+
+				current_aabb.expand_with(result);
+				return result;
+			}
 		}
 
-		decltype(auto) insert(const rect_wh& image_rectangle) {
+		constexpr decltype(auto) insert(const rect_wh_type& image_rectangle) {
 			return insert(image_rectangle, [](auto&){ });
 		}
 
-		auto get_rects_aabb() const {
+		/*
+			Tells the container that no rectangle narrower than smallest.w or lower than smallest.h
+			will ever be inserted from now on, e.g. because the caller knows all the remaining rectangles.
+
+			Spaces that are too small for that are then skipped by every later insert,
+			which marks them lazily as it comes across them.
+			Nothing could have been placed in them anyway, and the other spaces keep their order,
+			so the insertions end up exactly where they would without pruning.
+			The threshold is cleared on reset.
+
+			Pruning needs a provider whose get can modify the spaces (see empty_space_allocators.h),
+			and does nothing while merging_mode is not DISABLED.
+			The spaces of get_spaces then include the marked ones, with a negative width.
+		*/
+
+		constexpr void prune_spaces_below(const rect_wh_type& smallest) {
+			prune_below = smallest;
+		}
+
+		/*
+			Merges the whole list at once, regardless of merging_mode, in O(n log n).
+			Needs a provider whose get can modify the spaces (see empty_space_allocators.h).
+
+			The merged list is ordered by the edges of the spaces rather than by when they were split off,
+			so the later insertions may pick different spaces than without merging.
+		*/
+
+		constexpr void merge_spaces() {
+			static_assert(can_prune, "Merging needs a provider whose get can modify the spaces.");
+
+			remove_tombstones();
+
+			for (bool merged_any = true; merged_any;) {
+				const auto vertical_merges = merge_along<true>();
+				const auto horizontal_merges = merge_along<false>();
+
+				merged_any = vertical_merges + horizontal_merges > 0;
+			}
+
+			count_after_merge = spaces.get_count();
+		}
+
+		constexpr auto get_rects_aabb() const {
 			return current_aabb;
 		}
 
-		const auto& get_spaces() const {
+		constexpr const auto& get_spaces() const {
 			return spaces;
 		}
 	};
@@ -0,0 +1,450 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	struct exact_settings {
+		/* A node is a single insertion tried by the search. */
+		std::size_t max_nodes = 2000000;
+
+		std::chrono::milliseconds time_limit = std::chrono::milliseconds(1000);
+	};
+
+	struct exact_report {
+		/* The search ran to completion, so no order fits the rectangles into a smaller bin. */
+		bool optimal = false;
+
+		/* The search found a smaller bin than find_best_packing. */
+		bool improved = false;
+
+		std::size_t nodes = 0;
+	};
+
+	/*
+		Finds the best packing for a small number of rectangles - up to a few dozen -
+		e.g. sprite sheets shipped in every build, where every percent of area counts.
+
+		The rectangles are placed exactly as by the other finders - with empty_spaces, in some order -
+		but instead of trying a handful of orders, this searches all of them, for every legal bin width,
+		with a depth-first branch-and-bound over snapshots of empty_spaces:
+
+		- find_best_packing provides the first incumbent, and every bin at least as big as the incumbent is skipped,
+		- heights are bounded below by the total area, the tallest rectangle,
+		  and the rectangles too wide to stand side by side,
+		- a branch is cut once any remaining rectangle fits no empty space,
+		  or the spaces that could still hold any remaining rectangle are smaller than the remaining area,
+		- rectangles of the same size are interchangeable, so only one of them is ever tried at every depth.
+
+		Optimal thus means optimal among the packings that empty_spaces can produce:
+		no insertion order fits the rectangles into a smaller bin.
+		The bin may have any aspect ratio within max_bin_side, so lower max_bin_side to keep it from getting too narrow.
+		Flipping is left to empty_spaces, as in the other finders, and space merging is not used during the search.
+
+		The number of orders grows factorially, so once the search hits max_nodes or time_limit,
+		it stops and keeps the best packing found so far - at worst, the one of find_best_packing.
+
+		The callbacks are only invoked once the final packing is known.
+		If find_best_packing can't fit everything within max_bin_side, this is the same as calling it directly.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_exact(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const exact_settings& settings = exact_settings(),
+		exact_report* const report = nullptr
+	) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+		using rect_wh_type = rect_wh_t<empty_spaces_type>;
+		using coord_type = typename empty_spaces_type::coord_type;
+		using area_type = search_area_t<empty_spaces_type, A>;
+		using clock = std::chrono::steady_clock;
+
+		const auto& constraint = input.bin_constraint;
+		const bool flipping = input.flipping_mode == flipping_option::ENABLED;
+
+		exact_report result_report;
+
+		/*
+			find_best_packing writes to the rectangles - possibly flipping them -
+			so everything that follows starts over from these copies,
+			and the flipped flags end up relative to the sizes the caller passed.
+		*/
+
+		std::vector<rect_type*> all_rects;
+		std::vector<rect_type> originals;
+
+		for (auto& s : subjects) {
+			auto& r = s.get_rect();
+
+			all_rects.push_back(std::addressof(r));
+			originals.push_back(r);
+		}
+
+		const auto restore_originals = [&]() {
+			for (std::size_t i = 0; i < all_rects.size(); ++i) {
+				*all_rects[i] = originals[i];
+			}
+		};
+
+		bool all_placed = true;
+
+		const auto heuristic_input = make_finder_input_from(
+			input,
+			[](auto&) { return callback_result::CONTINUE_PACKING; },
+			[&all_placed](auto&) { all_placed = false; return callback_result::ABORT_PACKING; }
+		);
+
+		const auto heuristic_bin = find_best_packing<empty_spaces_type>(subjects, heuristic_input);
+
+		std::vector<rect_type> heuristic_results;
+		heuristic_results.reserve(all_rects.size());
+
+		for (const auto* r : all_rects) {
+			heuristic_results.push_back(*r);
+		}
+
+		restore_originals();
+
+		if (!all_placed) {
+			if (report) {
+				*report = result_report;
+			}
+
+			return find_best_packing<empty_spaces_type>(subjects, input);
+		}
+
+		/* Rectangles of the same aligned size are interchangeable. */
+
+		struct rect_kind {
+			rect_wh_type size;
+			std::vector<rect_type*> members;
+			std::size_t remaining = 0;
+		};
+
+		std::vector<rect_type*> placed_by_heuristic;
+		std::vector<rect_type> heuristic_placements;
+		std::vector<rect_kind> kinds;
+
+		area_type total_area = 0;
+		coord_type min_w = 0;
+		coord_type min_h = 0;
+
+		for (std::size_t i = 0; i < all_rects.size(); ++i) {
+			auto& r = *all_rects[i];
+
+			if (area_as<area_type>(r) == 0) {
+				continue;
+			}
+
+			placed_by_heuristic.push_back(std::addressof(r));
+			heuristic_placements.push_back(heuristic_results[i]);
+
+			const auto aligned = constraint.align(r.get_wh());
+
+			total_area += area_as<area_type>(aligned);
+			min_w = std::max(min_w, flipping ? aligned.min_side() : aligned.w);
+			min_h = std::max(min_h, flipping ? aligned.min_side() : aligned.h);
+
+			auto same_kind = std::find_if(kinds.begin(), kinds.end(), [&](const rect_kind& k) {
+				return k.size.w == aligned.w && k.size.h == aligned.h;
+			});
+
+			if (same_kind == kinds.end()) {
+				kinds.emplace_back();
+				kinds.back().size = aligned;
+				same_kind = std::prev(kinds.end());
+			}
+
+			same_kind->members.push_back(std::addressof(r));
+			++same_kind->remaining;
+		}
+
+		std::stable_sort(kinds.begin(), kinds.end(), [](const rect_kind& a, const rect_kind& b) {
+			return area_as<area_type>(a.size) > area_as<area_type>(b.size);
+		});
+
+		const auto rect_count = placed_by_heuristic.size();
+
+		if (rect_count == 0) {
+			result_report.optimal = true;
+
+			if (report) {
+				*report = result_report;
+			}
+
+			return heuristic_bin;
+		}
+
+		area_type best_area = area_as<area_type>(heuristic_bin);
+		rect_wh_type best_bin;
+		std::vector<std::size_t> best_sequence;
+
+		/* The lowest legal height that the rectangles could possibly fit under with this width. */
+
+		const auto min_height_for = [&](const coord_type w) {
+			area_type height = std::max(area_type(min_h), (total_area + w - 1) / w);
+			area_type too_wide_to_share_rows = 0;
+
+			for (const auto& k : kinds) {
+				const auto narrowest = flipping ? k.size.min_side() : k.size.w;
+
+				if (area_type(narrowest) * 2 > w) {
+					too_wide_to_share_rows += area_type(flipping ? k.size.min_side() : k.size.h) * k.members.size();
+				}
+			}
+
+			height = std::max(height, too_wide_to_share_rows);
+			return constraint.round_up(static_cast<coord_type>(std::min(height, area_type(input.max_bin_side) + 1)));
+		};
+
+		std::vector<coord_type> widths;
+
+		/* Stops at the last legal side within max_bin_side, as the one past it might not even be representable. */
+
+		const auto max_width_index = constraint.index_of(static_cast<coord_type>(input.max_bin_side));
+
+		for (auto index = constraint.index_of(min_w); index <= max_width_index; ++index) {
+			const auto w = constraint.side_of(index);
+
+			if (w >= min_w && w > 0) {
+				widths.push_back(w);
+			}
+		}
+
+		std::vector<area_type> width_bounds(widths.size());
+
+		for (std::size_t i = 0; i < widths.size(); ++i) {
+			width_bounds[i] = area_type(widths[i]) * min_height_for(widths[i]);
+		}
+
+		std::vector<std::size_t> width_order(widths.size());
+
+		for (std::size_t i = 0; i < width_order.size(); ++i) {
+			width_order[i] = i;
+		}
+
+		/* The most promising widths first. */
+
+		std::stable_sort(width_order.begin(), width_order.end(), [&](const std::size_t a, const std::size_t b) {
+			return width_bounds[a] < width_bounds[b];
+		});
+
+		const auto deadline = clock::now() + settings.time_limit;
+		bool out_of_budget = false;
+
+		std::vector<empty_spaces_type> snapshots(rect_count + 1, empty_spaces_type(rect_wh_type()));
+		std::vector<std::size_t> sequence;
+		area_type remaining_area = total_area;
+
+		auto& root = snapshots[0];
+		root.flipping_mode = input.flipping_mode;
+		root.merging_mode = space_merging_option::DISABLED;
+
+		const auto fits = [flipping](const auto& space, const rect_wh_type& r) {
+			return (r.w <= space.w && r.h <= space.h) || (flipping && r.h <= space.w && r.w <= space.h);
+		};
+
+		/* Whether the remaining rectangles could still fit into the empty spaces in any order. */
+
+		const auto can_still_fit = [&](const empty_spaces_type& current) {
+			const auto& spaces = current.get_spaces();
+			const auto count = static_cast<int>(spaces.get_count());
+
+			area_type usable_area = 0;
+
+			for (const auto& k : kinds) {
+				if (k.remaining == 0) {
+					continue;
+				}
+
+				bool fits_anywhere = false;
+
+				for (int i = 0; i < count && !fits_anywhere; ++i) {
+					fits_anywhere = fits(spaces.get(i), k.size);
+				}
+
+				if (!fits_anywhere) {
+					return false;
+				}
+			}
+
+			for (int i = 0; i < count; ++i) {
+				const auto& space = spaces.get(i);
+
+				for (const auto& k : kinds) {
+					if (k.remaining > 0 && fits(space, k.size)) {
+						usable_area += area_as<area_type>(space);
+						break;
+					}
+				}
+			}
+
+			return usable_area >= remaining_area;
+		};
+
+		coord_type width = 0;
+		std::size_t width_nodes = 0;
+		std::size_t width_node_limit = 0;
+		bool width_cut_short = false;
+
+		const auto search = [&](auto& self, const std::size_t depth) -> bool {
+			if (depth == rect_count) {
+				best_area = area_type(width) * constraint.round_up(snapshots[depth].get_rects_aabb().h);
+				best_sequence = sequence;
+				result_report.improved = true;
+
+				return true;
+			}
+
+			for (std::size_t k = 0; k < kinds.size(); ++k) {
+				auto& kind = kinds[k];
+
+				if (kind.remaining == 0) {
+					continue;
+				}
+
+				if (++result_report.nodes >= settings.max_nodes || (result_report.nodes % 1024 == 0 && clock::now() > deadline)) {
+					out_of_budget = true;
+					return false;
+				}
+
+				if (++width_nodes >= width_node_limit) {
+					width_cut_short = true;
+					return false;
+				}
+
+				auto& next = snapshots[depth + 1];
+				next = snapshots[depth];
+
+				if (!next.insert(kind.size)) {
+					continue;
+				}
+
+				if (area_type(width) * constraint.round_up(next.get_rects_aabb().h) >= best_area) {
+					continue;
+				}
+
+				--kind.remaining;
+				remaining_area -= area_as<area_type>(kind.size);
+				sequence.push_back(k);
+
+				const bool found = can_still_fit(next) && self(self, depth + 1);
+
+				sequence.pop_back();
+				remaining_area += area_as<area_type>(kind.size);
+				++kind.remaining;
+
+				if (found || out_of_budget || width_cut_short) {
+					return found;
+				}
+			}
+
+			return false;
+		};
+
+		/*
+			A single hard width could eat the whole budget while others would improve quickly,
+			so every width is searched with a node limit, which grows fourfold in every round.
+			A width is done once its search completes within the limit.
+		*/
+
+		std::vector<bool> width_done(widths.size(), false);
+		bool all_done = false;
+
+		for (width_node_limit = 1024; !all_done && !out_of_budget; width_node_limit *= 4) {
+			all_done = true;
+
+			for (const auto i : width_order) {
+				if (width_done[i] || out_of_budget) {
+					continue;
+				}
+
+				width = widths[i];
+
+				/* Every packing found with this width is smaller than the last one, so try again under it. */
+
+				while (true) {
+					if (width_bounds[i] >= best_area) {
+						width_done[i] = true;
+						break;
+					}
+
+					const auto height_limit = std::min(area_type(input.max_bin_side), (best_area - 1) / width);
+					const auto bin_height = constraint.side_of(constraint.index_of(static_cast<coord_type>(height_limit)));
+
+					root.reset(rect_wh_type(width, bin_height));
+
+					width_nodes = 0;
+					width_cut_short = false;
+
+					if (!can_still_fit(root)) {
+						width_done[i] = true;
+						break;
+					}
+
+					if (search(search, 0)) {
+						best_bin = rect_wh_type(width, bin_height);
+						continue;
+					}
+
+					width_done[i] = !width_cut_short && !out_of_budget;
+					break;
+				}
+
+				all_done = all_done && width_done[i];
+			}
+		}
+
+		result_report.optimal = all_done;
+
+		if (report) {
+			*report = result_report;
+		}
+
+		if (!result_report.improved) {
+			for (std::size_t i = 0; i < rect_count; ++i) {
+				auto& rect = *placed_by_heuristic[i];
+				rect = heuristic_placements[i];
+
+				if (callback_result::ABORT_PACKING == input.handle_successful_insertion(rect)) {
+					break;
+				}
+			}
+
+			return heuristic_bin;
+		}
+
+		/* Replays the best order, exactly as the search placed it. */
+
+		root.reset(best_bin);
+
+		for (auto& k : kinds) {
+			k.remaining = 0;
+		}
+
+		for (const auto k : best_sequence) {
+			auto& kind = kinds[k];
+			auto& rect = *kind.members[kind.remaining++];
+			const auto original_size = rect.get_wh();
+
+			if (const auto ret = root.insert(kind.size)) {
+				rect = with_size(*ret, original_size);
+
+				if (callback_result::ABORT_PACKING == input.handle_successful_insertion(rect)) {
+					break;
+				}
+			}
+			else {
+				if (callback_result::ABORT_PACKING == input.handle_unsuccessful_insertion(rect)) {
+					break;
+				}
+			}
+		}
+
+		return constraint.round_up(root.get_rects_aabb());
+	}
+}
@@ -1,100 +1,227 @@
 #pragma once
+#include <future>
 #include <memory>
+#include <memory_resource>
 #include "empty_spaces.h"
 #include "best_bin_finder.h"
+#include "fixed_bin_finder.h"
+#include "aspect_sweep_finder.h"
 #include "empty_space_allocators.h" // IWYU pragma: export
 
 namespace rectpack2D {
 	template <class empty_spaces_type>
 	using output_rect_t = typename empty_spaces_type::output_rect_type;
 
-	template <class F, class G>
+	template <class empty_spaces_type>
+	using rect_wh_t = typename empty_spaces_type::rect_wh_type;
+
+	/*
+		With PIPELINED, the finders sort only the first order before starting to search it,
+		while every other order is sorted on a thread of its own and searched as soon as it is ready.
+		For large inputs, this takes the sorting of all but the first order off the critical path.
+
+		The orders are still searched one after another, in the same sequence,
+		so the result is exactly the same as with SERIAL.
+
+		Each pipelined order costs a thread launch, which takes about as long as sorting 300 rectangles,
+		so inputs with fewer than pipelined_sorting_min_rects rectangles are always sorted serially.
+	*/
+
+	enum class order_sorting_option {
+		SERIAL,
+		PIPELINED
+	};
+
+	inline constexpr std::size_t pipelined_sorting_min_rects = 1024;
+
+	/*
+		A is the type in which the search computes areas (see search_area_t).
+		Leave it at void unless your bins may be bigger than about 46341 x 46341,
+		in which case call e.g. make_finder_input<std::int64_t>(...).
+	*/
+
+	template <class F, class G, class A = void>
 	struct finder_input {
+		using area_type = A;
+
 		const int max_bin_side;
 		const int discard_step;
 		F handle_successful_insertion;
 		G handle_unsuccessful_insertion;
 		const flipping_option flipping_mode;
+
+		/* Set these after make_finder_input, if needed. */
+
+		bin_size_constraint bin_constraint;
+		search_stats* stats;
+		space_pruning_option space_pruning;
+		space_merging_option space_merging;
+		incumbent_bound_option incumbent_bound;
+		order_sorting_option order_sorting;
 	};
 
-	template <class F, class G>
-	auto make_finder_input(
+	template <class A = void, class F, class G>
+	constexpr auto make_finder_input(
 		const int max_bin_side,
 		const int discard_step,
 		F&& handle_successful_insertion,
 		G&& handle_unsuccessful_insertion,
 		const flipping_option flipping_mode
 	) {
-		return finder_input<F, G> { 
+		return finder_input<F, G, A> { 
 			max_bin_side, 
 			discard_step, 
 			std::forward<F>(handle_successful_insertion),
 			std::forward<G>(handle_unsuccessful_insertion),
-			flipping_mode
+			flipping_mode,
+			bin_size_constraint(),
+			nullptr,
+			space_pruning_option::DISABLED,
+			space_merging_option::DISABLED,
+			incumbent_bound_option::ENABLED,
+			order_sorting_option::SERIAL
 		};
 	};
 
+	/*
+		For finders that wrap the callbacks of the caller:
+		the same input, but with other callbacks - and optionally another discard_step and flipping_mode.
+
+		Pass the callbacks of the input itself to reference them instead of copying them.
+	*/
+
+	template <class F, class G, class A, class NewF, class NewG>
+	constexpr auto make_finder_input_from(
+		const finder_input<F, G, A>& input,
+		NewF&& handle_successful_insertion,
+		NewG&& handle_unsuccessful_insertion,
+		const int discard_step,
+		const flipping_option flipping_mode
+	) {
+		return finder_input<NewF, NewG, A> {
+			input.max_bin_side,
+			discard_step,
+			std::forward<NewF>(handle_successful_insertion),
+			std::forward<NewG>(handle_unsuccessful_insertion),
+			flipping_mode,
+			input.bin_constraint,
+			input.stats,
+			input.space_pruning,
+			input.space_merging,
+			input.incumbent_bound,
+			input.order_sorting
+		};
+	}
+
+	template <class F, class G, class A, class NewF, class NewG>
+	constexpr auto make_finder_input_from(
+		const finder_input<F, G, A>& input,
+		NewF&& handle_successful_insertion,
+		NewG&& handle_unsuccessful_insertion
+	) {
+		return make_finder_input_from(
+			input,
+			std::forward<NewF>(handle_successful_insertion),
+			std::forward<NewG>(handle_unsuccessful_insertion),
+			input.discard_step,
+			input.flipping_mode
+		);
+	}
+
+	/*
+		Caller-owned scratch memory for the finders.
+
+		The root is used instead of the one re-used on the TLS,
+		and the orders are allocated from orders_memory instead of the heap.
+		Together with a warmed-up root (or a pmr_empty_spaces/static_empty_spaces provider)
+		and e.g. a monotonic_buffer_resource over a preallocated buffer,
+		the finders will then not allocate at all.
+	*/
+
+	template <class empty_spaces_type>
+	struct finder_scratch {
+		empty_spaces_type& root;
+		std::pmr::memory_resource* orders_memory;
+	};
+
+	template <class empty_spaces_type>
+	auto make_finder_scratch(
+		empty_spaces_type& root,
+		std::pmr::memory_resource* const orders_memory = std::pmr::get_default_resource()
+	) {
+		return finder_scratch<empty_spaces_type> {
+			root,
+			orders_memory
+		};
+	}
+
 	/*
 		Finds the best packing for the rectangles,
 		just in the order that they were passed.
 	*/
 
-	template <class empty_spaces_type, class Subjects, class F, class G>
-	rect_wh find_best_packing_dont_sort(
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_dont_sort(
+		const finder_scratch<empty_spaces_type> scratch,
 		Subjects& subjects,
-		const finder_input<F, G>& input
+		const finder_input<F, G, A>& input
 	) {
 		// Works with C arrays as well.
 		using iterator_type = decltype(std::begin(subjects));
 		using order_type = rectpack2D::span<iterator_type>;
 
 		return find_best_packing_impl<empty_spaces_type, order_type>(
+			scratch.root,
 			[&subjects](auto callback) { callback(order_type(std::begin(subjects), std::end(subjects))); },
 			input
 		);
 	}
 
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_dont_sort(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input
+	) {
+		return find_best_packing_dont_sort<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input
+		);
+	}
+
 
 	/*
-		Finds the best packing for the rectangles.
-		Accepts a list of predicates able to compare two input rectangles.
-	   
-		The function will try to pack the rectangles in all orders generated by the predicates,
-		and will only write the x, y coordinates of the best packing found among the orders.
+		Lets gather write the elements to be ordered - at most max_count of them - and return their count,
+		copies them once for each of the predicates, and sorts every copy with its predicate.
+
+		Then calls handler with a function that iterates over the sorted orders,
+		each being a rectpack2D::span<element_type*>.
+		With order_sorting_option::PIPELINED, all but the first order are sorted asynchronously,
+		and the iteration waits for each order to be sorted before passing it on.
 	*/
 
-	template <class empty_spaces_type, class Subjects, class F, class G, class Comparator, class... Comparators>
-	rect_wh find_best_packing(
-		Subjects& subjects,
-		const finder_input<F, G>& input,
+	template <class element_type, class G, class H, class Comparator, class... Comparators>
+	decltype(auto) with_sorted_orders_of(
+		std::pmr::memory_resource* const orders_memory,
+		const order_sorting_option sorting,
+		const std::size_t max_count,
+		G gather,
+		H handler,
 
 		Comparator comparator,
 		Comparators... comparators
 	) {
-		using rect_type = output_rect_t<empty_spaces_type>;
-		using order_type = rectpack2D::span<rect_type**>;
+		using order_type = rectpack2D::span<element_type*>;
 
 		constexpr auto count_orders = 1 + sizeof...(Comparators);
-		std::size_t count_valid_subjects = 0;
 
-		// Allocate space assuming no rectangle has an area of zero.
-		// We fill orders with valid rectangles only.
-		auto orders = std::make_unique<rect_type*[]>(count_orders * std::size(subjects));
-
-		for (auto& s : subjects) {
-			auto& r = s.get_rect();
-
-			if (r.area() == 0) {
-				continue;
-			}
-
-			orders[count_valid_subjects++] = std::addressof(r);
-		}
+		auto orders = std::pmr::vector<element_type>(count_orders * max_count, orders_memory);
+		const std::size_t count_valid_subjects = gather(orders.data());
 
 		auto ith_order = [&orders, n = count_valid_subjects](const std::size_t i) {
 			return order_type(
-				orders.get() + i       * n,
-				orders.get() + (i + 1) * n
+				orders.data() + i       * n,
+				orders.data() + (i + 1) * n
 			);
 		};
 
@@ -114,7 +241,32 @@ namespace rectpack2D {
 			}
 		}
 
-		{
+		/* 
+			Declared after the orders, so that pending sorts are waited for before the orders are freed,
+			even if the handler throws.
+			Shared, since the aspect sweep may iterate the orders from several threads at once (see aspect_sweep_settings::parallel_for).
+		*/
+
+		std::vector<std::shared_future<void>> pending_sorts;
+
+		if (sorting == order_sorting_option::PIPELINED && count_valid_subjects >= pipelined_sorting_min_rects) {
+			std::size_t i = 1;
+
+			/* Unused if there is only one comparator. */
+			[[maybe_unused]] auto make_order_later = [&i, &pending_sorts, ith_order](auto& predicate) {
+				const auto o = ith_order(i++);
+
+				pending_sorts.emplace_back(std::async(std::launch::async, [o, &predicate]() {
+					std::sort(o.begin(), o.end(), predicate);
+				}));
+			};
+
+			(make_order_later(comparators), ...);
+
+			const auto first_order = ith_order(0);
+			std::sort(first_order.begin(), first_order.end(), comparator);
+		}
+		else {
 			std::size_t i = 0;
 
 			auto make_order = [&i, ith_order](auto& predicate) {
@@ -126,35 +278,72 @@ namespace rectpack2D {
 			(make_order(comparators), ...);
 		}
 
-		return find_best_packing_impl<empty_spaces_type, order_type>(
-			[ith_order](auto callback) {
-				constexpr auto orders_count = 1 + sizeof...(Comparators);
-				for (std::size_t i = 0; i < orders_count; ++i) {
+		return handler(
+			[ith_order, &pending_sorts](auto callback) {
+				for (std::size_t i = 0; i < count_orders; ++i) {
+					if (i > 0 && i <= pending_sorts.size()) {
+						pending_sorts[i - 1].wait();
+					}
+
 					callback(ith_order(i));
 				}
-			},
-			input
+			}
 		);
 	}
 
 	/*
-		Finds the best packing for the rectangles.
-		Provides a list of several sensible comparison predicates.
+		Orders pointers to all rectangles of non-zero area, see with_sorted_orders_of.
+		The orders are rectpack2D::span<output_rect_t<empty_spaces_type>**>.
 	*/
 
-	template <class empty_spaces_type, class Subjects, class F, class G>
-	rect_wh find_best_packing(
+	template <class empty_spaces_type, class area_type, class Subjects, class H, class Comparator, class... Comparators>
+	decltype(auto) with_sorted_orders(
+		std::pmr::memory_resource* const orders_memory,
+		const order_sorting_option sorting,
 		Subjects& subjects,
-		const finder_input<F, G>& input
+		H handler,
+
+		Comparator comparator,
+		Comparators... comparators
 	) {
 		using rect_type = output_rect_t<empty_spaces_type>;
 
-		return find_best_packing<empty_spaces_type>(
-			subjects,
-			input,
+		return with_sorted_orders_of<rect_type*>(
+			orders_memory,
+			sorting,
+			std::size(subjects),
+			[&subjects](rect_type** const valid) {
+				std::size_t count_valid = 0;
+
+				for (auto& s : subjects) {
+					auto& r = s.get_rect();
+
+					if (area_as<area_type>(r) != 0) {
+						valid[count_valid++] = std::addressof(r);
+					}
+				}
+
+				return count_valid;
+			},
+			handler,
+
+			comparator,
+			comparators...
+		);
+	}
 
+	/*
+		Calls handler with several sensible comparison predicates.
+		Usable in constant expressions, see find_best_packing_constexpr.
+	*/
+
+	template <class empty_spaces_type, class area_type, class H>
+	constexpr decltype(auto) with_default_comparators(H handler) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+
+		return handler(
 			[](const rect_type* const a, const rect_type* const b) {
-				return a->area() > b->area();
+				return area_as<area_type>(*a) > area_as<area_type>(*b);
 			},
 			[](const rect_type* const a, const rect_type* const b) {
 				return a->perimeter() > b->perimeter();
@@ -170,4 +359,288 @@ namespace rectpack2D {
 			}
 		);
 	}
+
+	/*
+		Finds the best packing for the rectangles.
+		Accepts a list of predicates able to compare two input rectangles.
+	   
+		The function will try to pack the rectangles in all orders generated by the predicates,
+		and will only write the x, y coordinates of the best packing found among the orders.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		using order_type = rectpack2D::span<output_rect_t<empty_spaces_type>**>;
+		using area_type = search_area_t<empty_spaces_type, A>;
+
+		return with_sorted_orders<empty_spaces_type, area_type>(
+			scratch.orders_memory,
+			input.order_sorting,
+			subjects,
+			[&](auto for_each_order) {
+				return find_best_packing_impl<empty_spaces_type, order_type>(
+					scratch.root,
+					for_each_order,
+					input
+				);
+			},
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		return find_best_packing<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input,
+
+			comparator,
+			comparators...
+		);
+	}
+
+	/*
+		Finds the best packing for the rectangles.
+		Provides a list of several sensible comparison predicates.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input
+	) {
+		return with_default_comparators<empty_spaces_type, search_area_t<empty_spaces_type, A>>(
+			[&](auto... comparators) {
+				return find_best_packing<empty_spaces_type>(
+					scratch,
+					subjects,
+					input,
+
+					comparators...
+				);
+			}
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input
+	) {
+		return find_best_packing<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input
+		);
+	}
+
+	/*
+		Packs the rectangles into a bin of exactly the given size, e.g. a 2048x2048 page,
+		skipping the bin size search entirely.
+
+		Every order is tried just once, and the one that places the most area
+		(or the most rectangles, with fixed_bin_criterion::MOST_RECTS) is written back through the callbacks.
+		max_bin_side and discard_step of the input are ignored.
+
+		Returns the area actually used - the bounding box of the placed rectangles,
+		rounded up according to bin_constraint - not the passed bin,
+		e.g. 30x10 for a 10x10 and a 20x5 rectangle in a 512x512 bin.
+		This lets a caller shrink the page to what was used, as find_best_packing_hierarchical does with its strips.
+	*/
+
+	template <class empty_spaces_type, fixed_bin_criterion criterion = fixed_bin_criterion::MOST_AREA, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_packing_in_bin(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const rect_wh_t<empty_spaces_type> bin,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		using order_type = rectpack2D::span<output_rect_t<empty_spaces_type>**>;
+		using area_type = search_area_t<empty_spaces_type, A>;
+
+		return with_sorted_orders<empty_spaces_type, area_type>(
+			scratch.orders_memory,
+			input.order_sorting,
+			subjects,
+			[&](auto for_each_order) {
+				return find_packing_in_bin_impl<empty_spaces_type, order_type, criterion>(
+					scratch.root,
+					for_each_order,
+					bin,
+					input
+				);
+			},
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, fixed_bin_criterion criterion = fixed_bin_criterion::MOST_AREA, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_packing_in_bin(
+		Subjects& subjects,
+		const rect_wh_t<empty_spaces_type> bin,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		return find_packing_in_bin<empty_spaces_type, criterion>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			bin,
+			input,
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, fixed_bin_criterion criterion = fixed_bin_criterion::MOST_AREA, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_packing_in_bin(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const rect_wh_t<empty_spaces_type> bin,
+		const finder_input<F, G, A>& input
+	) {
+		return with_default_comparators<empty_spaces_type, search_area_t<empty_spaces_type, A>>(
+			[&](auto... comparators) {
+				return find_packing_in_bin<empty_spaces_type, criterion>(
+					scratch,
+					subjects,
+					bin,
+					input,
+
+					comparators...
+				);
+			}
+		);
+	}
+
+	template <class empty_spaces_type, fixed_bin_criterion criterion = fixed_bin_criterion::MOST_AREA, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_packing_in_bin(
+		Subjects& subjects,
+		const rect_wh_t<empty_spaces_type> bin,
+		const finder_input<F, G, A>& input
+	) {
+		return find_packing_in_bin<empty_spaces_type, criterion>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			bin,
+			input
+		);
+	}
+
+	/*
+		Like find_best_packing, but searches from starting bins of several aspect ratios
+		(see aspect_sweep_settings) and returns the smallest bin according to settings.objective.
+
+		Pass a search_stats through finder_input::stats to see the trials spent in total.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing_aspect_sweep(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const aspect_sweep_settings& settings,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		using order_type = rectpack2D::span<output_rect_t<empty_spaces_type>**>;
+		using area_type = search_area_t<empty_spaces_type, A>;
+
+		return with_sorted_orders<empty_spaces_type, area_type>(
+			scratch.orders_memory,
+			input.order_sorting,
+			subjects,
+			[&](auto for_each_order) {
+				return find_best_packing_aspect_sweep_impl<empty_spaces_type, order_type>(
+					scratch.root,
+					for_each_order,
+					input,
+					settings
+				);
+			},
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing_aspect_sweep(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const aspect_sweep_settings& settings,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		return find_best_packing_aspect_sweep<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input,
+			settings,
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_aspect_sweep(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const aspect_sweep_settings& settings = aspect_sweep_settings()
+	) {
+		return with_default_comparators<empty_spaces_type, search_area_t<empty_spaces_type, A>>(
+			[&](auto... comparators) {
+				return find_best_packing_aspect_sweep<empty_spaces_type>(
+					scratch,
+					subjects,
+					input,
+					settings,
+
+					comparators...
+				);
+			}
+		);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing_aspect_sweep(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const aspect_sweep_settings& settings = aspect_sweep_settings()
+	) {
+		return find_best_packing_aspect_sweep<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input,
+			settings
+		);
+	}
 }
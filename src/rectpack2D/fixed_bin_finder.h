@@ -0,0 +1,97 @@
+#pragma once
+#include "best_bin_finder.h"
+
+namespace rectpack2D {
+	enum class fixed_bin_criterion {
+		MOST_AREA,
+		MOST_RECTS
+	};
+
+	/*
+		This function will pack the rectangles into a bin of exactly the given size,
+		once per order, skipping the rectangles that do not fit.
+
+		There is no search for the bin size whatsoever -
+		the order that placed the most area (or the most rectangles) wins.
+		Only the winning order will have results written to.
+
+		Returns the bounding box of the placed rectangles, not the bin.
+	*/
+
+	template <
+		class empty_spaces_type,
+		class order_type,
+		fixed_bin_criterion criterion,
+		class F,
+		class I
+	>
+	auto find_packing_in_bin_impl(
+		empty_spaces_type& root,
+		F for_each_order,
+		const typename empty_spaces_type::rect_wh_type bin,
+		const I input
+	) {
+		using rect_wh_type = typename empty_spaces_type::rect_wh_type;
+		using area_type = search_area_t<empty_spaces_type, typename I::area_type>;
+
+		const auto& constraint = input.bin_constraint;
+
+		std::optional<order_type> best_order;
+
+		area_type best_score = -1;
+		area_type max_score = 0;
+
+		const bool pruning = input.space_pruning == space_pruning_option::ENABLED;
+		std::vector<rect_wh_type> smallest_remaining;
+
+		root.flipping_mode = input.flipping_mode;
+		root.merging_mode = input.space_merging;
+
+		for_each_order ([&](const order_type& current_order) {
+			if (best_score == max_score) {
+				/* Some previous order already placed everything. */
+				return;
+			}
+
+			if (pruning) {
+				find_smallest_remaining(smallest_remaining, current_order, input);
+			}
+
+			root.reset(bin);
+
+			if (input.stats) {
+				++input.stats->trials;
+			}
+
+			area_type score = 0;
+			max_score = 0;
+
+			std::size_t position = 0;
+
+			for (const auto& r : current_order) {
+				const auto& rect = dereference(r).get_rect();
+
+				if (pruning) {
+					root.prune_spaces_below(smallest_remaining[position++]);
+				}
+
+				const auto rect_score = criterion == fixed_bin_criterion::MOST_AREA ? area_as<area_type>(rect) : area_type(1);
+
+				max_score += rect_score;
+
+				if (root.insert(constraint.align(rect.get_wh()))) {
+					score += rect_score;
+				}
+			}
+
+			if (score > best_score) {
+				best_order = current_order;
+				best_score = score;
+			}
+		});
+
+		assert(best_order.has_value());
+
+		return write_packing(root, *best_order, bin, input);
+	}
+}
@@ -0,0 +1,396 @@
+#pragma once
+#include <map>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	/*
+		Clustering functors for find_best_packing_hierarchical.
+		Each maps a rectangle to the key of its cluster.
+	*/
+
+	struct single_cluster {
+		template <class R>
+		std::size_t operator()(const R&) const {
+			return 0;
+		}
+	};
+
+	/* Rectangles whose longer sides fall between the same powers of two go into the same cluster. */
+
+	struct cluster_by_size_class {
+		template <class R>
+		std::size_t operator()(const R& r) const {
+			std::size_t size_class = 0;
+
+			for (auto side = r.get_wh().max_side(); side > 1; side /= 2) {
+				++size_class;
+			}
+
+			return size_class;
+		}
+	};
+
+	struct hierarchical_settings {
+		/*
+			Clusters are split into as many tiles as needed to hold at most this many rectangles each -
+			unless the strips would then get too low for the tallest rectangles.
+		*/
+		std::size_t max_tile_rects = 2048;
+
+		/* Pack the tiles on std::thread::hardware_concurrency() threads. */
+		bool parallel = true;
+	};
+
+	/*
+		Finds a packing for very large inputs in two levels.
+
+		The rectangles are grouped into clusters by the passed functor,
+		which maps every rectangle to a cluster key - by default, all of them go into a single cluster.
+		Clusters are split into tiles of at most max_tile_rects rectangles,
+		and every tile is packed with find_packing_in_bin - possibly in parallel -
+		into a horizontal strip as wide as the final bin is expected to be,
+		using the lowest height that fits it whole.
+		The strips are then stacked on top of each other in the final bin.
+
+		Every search only sees a fraction of the rectangles,
+		so this is many times faster than a single search over all of them,
+		at the cost of the space lost along the top edge of every strip.
+		Keeping all sizes in one cluster lets the small rectangles fill those gaps,
+		which packed noticeably tighter than cluster_by_size_class in our measurements.
+
+		The callbacks are only invoked once everything has been placed.
+		Rectangles of zero area take no space, so they are reported as placed at the origin after all the others.
+		If a strip or the stack of them does not fit within max_bin_side,
+		this falls back to the flat find_best_packing, which reports the unsuccessful insertions as usual.
+		The fallback tries the default orders with the rectangles of every cluster kept together,
+		clusters with larger rectangles first.
+
+		The strips packed on the calling thread use the root and orders_memory of the scratch,
+		the ones packed on the other threads use their thread_local_root.
+	*/
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Cluster = single_cluster>
+	rect_wh_t<empty_spaces_type> find_best_packing_hierarchical(
+		const finder_scratch<empty_spaces_type> scratch,
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const hierarchical_settings& settings = hierarchical_settings(),
+		Cluster cluster_of = Cluster()
+	) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+		using rect_wh_type = rect_wh_t<empty_spaces_type>;
+		using coord_type = typename empty_spaces_type::coord_type;
+		using area_type = search_area_t<empty_spaces_type, A>;
+
+		struct tile {
+			std::vector<rect_type*> originals;
+			std::vector<rect_type> rects;
+			area_type area = 0;
+			search_stats stats;
+		};
+
+		std::map<std::size_t, std::vector<rect_type*>> clusters;
+		std::vector<rect_type*> zero_area;
+
+		area_type total_area = 0;
+		coord_type widest = 0;
+		coord_type tallest = 0;
+
+		for (auto& s : subjects) {
+			auto& r = s.get_rect();
+
+			if (area_as<area_type>(r) == 0) {
+				zero_area.push_back(std::addressof(r));
+				continue;
+			}
+
+			clusters[cluster_of(r)].push_back(std::addressof(r));
+			total_area += area_as<area_type>(r);
+
+			const auto aligned = input.bin_constraint.align(r.get_wh());
+			const bool flipping = input.flipping_mode == flipping_option::ENABLED;
+
+			widest = std::max(widest, flipping ? aligned.min_side() : aligned.w);
+			tallest = std::max(tallest, flipping ? aligned.min_side() : aligned.h);
+		}
+
+		const auto report_zero_area = [&]() {
+			for (auto* const r : zero_area) {
+				r->x = 0;
+				r->y = 0;
+
+				if (input.handle_successful_insertion(*r) == callback_result::ABORT_PACKING) {
+					return;
+				}
+			}
+		};
+
+		if (clusters.empty()) {
+			report_zero_area();
+			return {};
+		}
+
+		/*
+			Every tile becomes a horizontal strip as wide as the final bin is expected to be,
+			with the lowest height that still fits all of its rectangles.
+			The strips are then just stacked on top of each other,
+			so the only space lost is along the ragged top edge of every strip.
+		*/
+
+		const auto strip_width = static_cast<coord_type>(std::min(
+			static_cast<double>(input.max_bin_side),
+			std::max(static_cast<double>(widest), std::ceil(std::sqrt(static_cast<double>(total_area))))
+		));
+
+		std::vector<tile> tiles;
+
+		for (auto& c : clusters) {
+			auto& members = c.second;
+
+			area_type cluster_area = 0;
+
+			for (const auto* r : members) {
+				cluster_area += area_as<area_type>(*r);
+			}
+
+			/*
+				Strips not much taller than their rectangles lose most of their space along the edges,
+				so there are never more tiles than it takes to keep them a few times taller than the tallest rectangle.
+			*/
+
+			const auto max_tile_rects = std::max(std::size_t(1), settings.max_tile_rects);
+			const auto min_strip_area = area_type(4) * strip_width * std::max(coord_type(1), tallest);
+
+			const auto cluster_tiles = std::max(std::size_t(1), std::min(
+				(members.size() + max_tile_rects - 1) / max_tile_rects,
+				static_cast<std::size_t>(cluster_area / min_strip_area)
+			));
+
+			/*
+				Deal the rectangles of a cluster, largest first, into its tiles in turn,
+				so that every tile gets the same mix of sizes.
+				Small rectangles then fill the gaps between the big ones in each strip.
+			*/
+
+			std::stable_sort(members.begin(), members.end(), [](const rect_type* const a, const rect_type* const b) {
+				return area_as<area_type>(*a) > area_as<area_type>(*b);
+			});
+
+			const auto first_tile = tiles.size();
+			tiles.resize(first_tile + cluster_tiles);
+
+			for (std::size_t k = 0; k < members.size(); ++k) {
+				auto& t = tiles[first_tile + k % cluster_tiles];
+
+				t.originals.push_back(members[k]);
+				t.rects.push_back(*members[k]);
+				t.area += area_as<area_type>(*members[k]);
+			}
+		}
+
+		std::atomic<bool> failed = false;
+
+		/* The strips only need to honour the alignment - the final bin gets the bin size constraint. */
+
+		auto strip_constraint = input.bin_constraint;
+		strip_constraint.rule = bin_size_rule::ANY;
+
+		std::vector<rect_wh_type> strips(tiles.size());
+
+		const auto pack_tile = [&](const finder_scratch<empty_spaces_type> tile_scratch, const std::size_t i) {
+			auto& t = tiles[i];
+			bool all_placed = true;
+
+			auto tile_input = make_finder_input_from(
+				input,
+				[](auto&) { return callback_result::CONTINUE_PACKING; },
+				[&all_placed](auto&) { all_placed = false; return callback_result::ABORT_PACKING; }
+			);
+
+			tile_input.bin_constraint = strip_constraint;
+			tile_input.stats = input.stats ? &t.stats : nullptr;
+
+			const auto fits = [&](const coord_type height) {
+				/* Every attempt writes to the rectangles - possibly flipping them - so start over from the originals. */
+
+				for (std::size_t k = 0; k < t.rects.size(); ++k) {
+					t.rects[k] = *t.originals[k];
+				}
+
+				all_placed = true;
+
+				strips[i] = find_packing_in_bin<empty_spaces_type, fixed_bin_criterion::MOST_RECTS>(
+					tile_scratch,
+					t.rects, 
+					rect_wh_type(strip_width, height), 
+					tile_input
+				);
+
+				return all_placed;
+			};
+
+			auto lowest_failing = static_cast<coord_type>(std::max(area_type(1), t.area / strip_width) - 1);
+			auto lowest_fitting = static_cast<coord_type>(input.max_bin_side);
+
+			if (!fits(lowest_fitting)) {
+				failed = true;
+				return;
+			}
+
+			const auto step = std::max(1, input.discard_step);
+			auto last_tried = lowest_fitting;
+
+			while (lowest_fitting - lowest_failing > step) {
+				last_tried = static_cast<coord_type>(lowest_failing + (lowest_fitting - lowest_failing) / 2);
+
+				if (fits(last_tried)) {
+					lowest_fitting = last_tried;
+				}
+				else {
+					lowest_failing = last_tried;
+				}
+			}
+
+			if (last_tried != lowest_fitting) {
+				fits(lowest_fitting);
+			}
+		};
+
+		const auto worker_count = settings.parallel ? std::min<std::size_t>(
+			tiles.size(),
+			std::max(1u, std::thread::hardware_concurrency())
+		) : std::size_t(1);
+
+		if (worker_count > 1) {
+			std::atomic<std::size_t> next_tile = 0;
+
+			const auto work = [&](const finder_scratch<empty_spaces_type> worker_scratch) {
+				for (auto i = next_tile++; i < tiles.size() && !failed; i = next_tile++) {
+					pack_tile(worker_scratch, i);
+				}
+			};
+
+			std::vector<std::future<void>> pending;
+
+			for (std::size_t w = 1; w < worker_count; ++w) {
+				pending.emplace_back(std::async(std::launch::async, [&work]() {
+					work(make_finder_scratch(thread_local_root<empty_spaces_type>()));
+				}));
+			}
+
+			work(scratch);
+
+			for (auto& p : pending) {
+				p.get();
+			}
+		}
+		else {
+			for (std::size_t i = 0; i < tiles.size() && !failed; ++i) {
+				pack_tile(scratch, i);
+			}
+		}
+
+		if (input.stats) {
+			for (const auto& t : tiles) {
+				input.stats->trials += t.stats.trials;
+			}
+		}
+
+		area_type stacked_height = 0;
+
+		for (const auto& s : strips) {
+			stacked_height += s.h;
+		}
+
+		if (failed || stacked_height > input.max_bin_side) {
+			/* Clusters are ranked by their largest rectangle, which comes first in its members. */
+
+			std::map<std::size_t, area_type> largest_in;
+
+			for (const auto& c : clusters) {
+				largest_in[c.first] = area_as<area_type>(*c.second.front());
+			}
+
+			const auto by_cluster = [&largest_in, &cluster_of](auto comparator) {
+				return [&largest_in, &cluster_of, comparator](const rect_type* const a, const rect_type* const b) {
+					const auto cluster_a = cluster_of(*a);
+					const auto cluster_b = cluster_of(*b);
+
+					if (cluster_a != cluster_b) {
+						const auto largest_a = largest_in.at(cluster_a);
+						const auto largest_b = largest_in.at(cluster_b);
+
+						return largest_a != largest_b ? largest_a > largest_b : cluster_a < cluster_b;
+					}
+
+					return comparator(a, b);
+				};
+			};
+
+			const auto result = with_default_comparators<empty_spaces_type, area_type>(
+				[&](auto... comparators) {
+					return find_best_packing<empty_spaces_type>(
+						scratch,
+						subjects,
+						input,
+
+						by_cluster(comparators)...
+					);
+				}
+			);
+
+			report_zero_area();
+			return result;
+		}
+
+		const auto& constraint = input.bin_constraint;
+
+		rect_wh_type aabb;
+		coord_type strip_y = 0;
+
+		for (std::size_t i = 0; i < tiles.size(); ++i) {
+			const auto& t = tiles[i];
+
+			for (std::size_t k = 0; k < t.rects.size(); ++k) {
+				auto& rect = *t.originals[k];
+
+				rect = t.rects[k];
+				rect.y = static_cast<coord_type>(rect.y + strip_y);
+
+				const auto aligned = constraint.align(rect.get_wh());
+				aabb.expand_with(basic_rect_xywh<coord_type>(rect.x, rect.y, aligned.w, aligned.h));
+
+				if (input.handle_successful_insertion(rect) == callback_result::ABORT_PACKING) {
+					return constraint.round_up(aabb);
+				}
+			}
+
+			strip_y = static_cast<coord_type>(strip_y + strips[i].h);
+		}
+
+		report_zero_area();
+		return constraint.round_up(aabb);
+	}
+
+	template <class empty_spaces_type, class Subjects, class F, class G, class A, class Cluster = single_cluster>
+	rect_wh_t<empty_spaces_type> find_best_packing_hierarchical(
+		Subjects& subjects,
+		const finder_input<F, G, A>& input,
+		const hierarchical_settings& settings = hierarchical_settings(),
+		Cluster cluster_of = Cluster()
+	) {
+		return find_best_packing_hierarchical<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			subjects,
+			input,
+			settings,
+			cluster_of
+		);
+	}
+}
@@ -3,38 +3,45 @@
 #include "rect_structs.h"
 
 namespace rectpack2D {
-	struct created_splits {
+	template <class T>
+	struct basic_created_splits {
 		int count = 0;
-		std::array<space_rect, 2> spaces;
+		std::array<basic_rect_xywh<T>, 2> spaces;
 
-		static auto failed() {
-			created_splits result;
+		static constexpr auto failed() {
+			basic_created_splits result;
 			result.count = -1;
 			return result;
 		}
 
-		static auto none() {
-			return created_splits();
+		static constexpr auto none() {
+			return basic_created_splits();
 		}
 
 		template <class... Args>
-		created_splits(Args&&... args) : spaces({ std::forward<Args>(args)... }) {
+		constexpr basic_created_splits(Args&&... args) : spaces({ std::forward<Args>(args)... }) {
 			count = sizeof...(Args);
 		}
 
-		bool better_than(const created_splits& b) const {
+		constexpr bool better_than(const basic_created_splits& b) const {
 			return count < b.count;
 		}
 
-		explicit operator bool() const {
+		constexpr explicit operator bool() const {
 			return count != -1;
 		}
 	};
 
-	inline created_splits insert_and_split(
-		const rect_wh& im, /* Image rectangle */
-		const space_rect& sp /* Space rectangle */
+	using created_splits = basic_created_splits<int>;
+
+	template <class T>
+	constexpr basic_created_splits<T> insert_and_split(
+		const basic_rect_wh<T>& im, /* Image rectangle */
+		const basic_rect_xywh<T>& sp /* Space rectangle */
 	) {
+		using space_rect_type = basic_rect_xywh<T>;
+		using created_splits_type = basic_created_splits<T>;
+
 		const auto free_w = sp.w - im.w;
 		const auto free_h = sp.h - im.h;
 
@@ -44,7 +51,7 @@ namespace rectpack2D {
 				We'll need to look further.
 			*/
 
-			return created_splits::failed();
+			return created_splits_type::failed();
 		}
 
 		if (free_w == 0 && free_h == 0) {
@@ -53,7 +60,7 @@ namespace rectpack2D {
 				we will just delete the space and create no splits.  
 			*/
 
-			return created_splits::none();
+			return created_splits_type::none();
 		}
 
 		/*
@@ -67,14 +74,14 @@ namespace rectpack2D {
 			auto r = sp;
 			r.x += im.w;
 			r.w -= im.w;
-			return created_splits(r);
+			return created_splits_type(r);
 		}
 
 		if (free_w == 0 && free_h > 0) {
 			auto r = sp;
 			r.y += im.h;
 			r.h -= im.h;
-			return created_splits(r);
+			return created_splits_type(r);
 		}
 
 		/* 
@@ -99,37 +106,37 @@ namespace rectpack2D {
 		*/
 
 		if (free_w > free_h) {
-			const auto bigger_split = space_rect(
+			const auto bigger_split = space_rect_type(
 				sp.x + im.w,
 				sp.y,
 			   	free_w,
 			   	sp.h
 			);
 
-			const auto lesser_split = space_rect(
+			const auto lesser_split = space_rect_type(
 				sp.x,
 				sp.y + im.h,
 				im.w,
 				free_h
 			);
 
-			return created_splits(bigger_split, lesser_split);
+			return created_splits_type(bigger_split, lesser_split);
 		}
 
-		const auto bigger_split = space_rect(
+		const auto bigger_split = space_rect_type(
 			sp.x,
 			sp.y + im.h,
 			sp.w,
 			free_h
 		);
 
-		const auto lesser_split = space_rect(
+		const auto lesser_split = space_rect_type(
 			sp.x + im.w,
 			sp.y,
 			free_w,
 			im.h
 		);
 
-		return created_splits(bigger_split, lesser_split);
+		return created_splits_type(bigger_split, lesser_split);
 	}
 }
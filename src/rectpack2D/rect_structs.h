@@ -1,90 +1,185 @@
 #pragma once
+#include <cstdint>
 #include <algorithm>
+#include <type_traits>
 
 namespace rectpack2D {
 	using total_area_type = int;
 
-	struct rect_wh {
-		rect_wh() : w(0), h(0) {}
-		rect_wh(const int w_, const int h_) : w(w_), h(h_) {}
+	/*
+		All rectangles are templated on the type of their coordinates,
+		e.g. std::int16_t for atlases that never exceed 16384 x 16384, or std::int64_t for huge ones.
+		The int aliases below (rect_wh, rect_xywh, rect_xywhf) are what you want most of the time.
 
-		int w;
-		int h;
+		Areas and perimeters are computed in a type wide enough that they can never overflow:
+		int for std::int16_t coordinates, and std::int64_t for int and std::int64_t coordinates.
+	*/
 
-		auto& flip() {
-			std::swap(w, h);
+	template <class T>
+	using area_type_t = std::conditional_t<(sizeof(T) < sizeof(int)), int, std::conditional_t<(sizeof(T) < sizeof(std::int64_t)), std::int64_t, T>>;
+
+	/*
+		The narrowest type that is at least int and at least as wide as the coordinates.
+		The search computes its areas in it unless told otherwise (see search_area_t),
+		as it is the fastest - but it overflows for int bins bigger than about 46341 x 46341.
+	*/
+
+	template <class T>
+	using fast_area_type_t = std::conditional_t<(sizeof(T) < sizeof(int)), int, T>;
+
+	template <class T>
+	struct basic_rect_wh {
+		using coord_type = T;
+
+		constexpr basic_rect_wh() : w(0), h(0) {}
+		constexpr basic_rect_wh(const T w_, const T h_) : w(w_), h(h_) {}
+
+		T w;
+		T h;
+
+		/* Not std::swap, which is not constexpr until C++20. */
+
+		constexpr auto& flip() {
+			const auto old_w = w;
+			w = h;
+			h = old_w;
 			return *this;
 		}
 
-		int max_side() const {
+		constexpr T max_side() const {
 			return h > w ? h : w;
 		}
 
-		int min_side() const {
+		constexpr T min_side() const {
 			return h < w ? h : w;
 		}
 
-		int	area() const { return w * h; }
-	   	int perimeter() const { return 2 * w + 2 * h; }
+		constexpr area_type_t<T> area() const { return area_type_t<T>(w) * h; }
+		constexpr area_type_t<T> perimeter() const { return 2 * area_type_t<T>(w) + 2 * area_type_t<T>(h); }
 
 		template <class R>
-		void expand_with(const R& r) {
-			w = std::max(w, r.x + r.w);
-			h = std::max(h, r.y + r.h);
+		constexpr void expand_with(const R& r) {
+			w = std::max(w, static_cast<T>(r.x + r.w));
+			h = std::max(h, static_cast<T>(r.y + r.h));
 		}
 	};
 
-	struct rect_xywh {
-		int x;
-		int	y;
-		int w;
-		int h;
+	template <class T>
+	struct basic_rect_xywh {
+		using coord_type = T;
+
+		T x;
+		T y;
+		T w;
+		T h;
 
-		rect_xywh() : x(0), y(0), w(0), h(0) {}
-		rect_xywh(const int x_, const int y_, const int w_, const int h_) : x(x_), y(y_), w(w_), h(h_) {}
+		constexpr basic_rect_xywh() : x(0), y(0), w(0), h(0) {}
+		constexpr basic_rect_xywh(const T x_, const T y_, const T w_, const T h_) : x(x_), y(y_), w(w_), h(h_) {}
 
-		int	area() const { return w * h; }
-		int perimeter() const { return 2 * w + 2 * h; }
+		constexpr area_type_t<T> area() const { return area_type_t<T>(w) * h; }
+		constexpr area_type_t<T> perimeter() const { return 2 * area_type_t<T>(w) + 2 * area_type_t<T>(h); }
 
-		auto get_wh() const {
-			return rect_wh(w, h);
+		constexpr auto get_wh() const {
+			return basic_rect_wh<T>(w, h);
 		}
 
-		auto& get_rect() {
+		constexpr auto& get_rect() {
 			return *this;
 		}
 
-		const auto& get_rect() const {
+		constexpr const auto& get_rect() const {
 			return *this;
 		}
 	};
 
-	struct rect_xywhf {
-		int x;
-		int y;
-		int w;
-		int h;
+	template <class T>
+	struct basic_rect_xywhf {
+		using coord_type = T;
+
+		T x;
+		T y;
+		T w;
+		T h;
 		bool flipped;
 
-		rect_xywhf() : x(0), y(0), w(0), h(0), flipped(false) {}
-		rect_xywhf(const int x_, const int y_, const int w_, const int h_, const bool flipped_) : x(x_), y(y_), w(flipped_ ? h_ : w_), h(flipped_ ? w_ : h_), flipped(flipped_) {}
-		rect_xywhf(const rect_xywh& b) : rect_xywhf(b.x, b.y, b.w, b.h, false) {}
+		constexpr basic_rect_xywhf() : x(0), y(0), w(0), h(0), flipped(false) {}
+		constexpr basic_rect_xywhf(const T x_, const T y_, const T w_, const T h_, const bool flipped_) : x(x_), y(y_), w(flipped_ ? h_ : w_), h(flipped_ ? w_ : h_), flipped(flipped_) {}
+		constexpr basic_rect_xywhf(const basic_rect_xywh<T>& b) : basic_rect_xywhf(b.x, b.y, b.w, b.h, false) {}
 
-		int	area() const { return w * h; }
-		int perimeter() const { return 2 * w + 2 * h; }
+		constexpr area_type_t<T> area() const { return area_type_t<T>(w) * h; }
+		constexpr area_type_t<T> perimeter() const { return 2 * area_type_t<T>(w) + 2 * area_type_t<T>(h); }
 
-		auto get_wh() const {
-			return rect_wh(w, h);
+		constexpr auto get_wh() const {
+			return basic_rect_wh<T>(w, h);
 		}
 
-		auto& get_rect() {
+		constexpr auto& get_rect() {
 			return *this;
 		}
 
-		const auto& get_rect() const {
+		constexpr const auto& get_rect() const {
 			return *this;
 		}
 	};
 
+	/*
+		Same as basic_rect_xywhf, but the flipped flag is packed into the top bit of h,
+		so that the struct is no bigger than basic_rect_xywh - e.g. 8 instead of 10 bytes with std::int16_t.
+		Pass it as the last template argument of empty_spaces to have the finders write it.
+
+		h is a bit-field, so it can't be referenced, have its address taken or be passed to std::swap,
+		and it has one bit less than the other coordinates,
+		e.g. 16383 is the tallest rectangle representable with std::int16_t.
+	*/
+
+	template <class T>
+	struct basic_compact_rect_xywhf {
+		using coord_type = T;
+
+		T x;
+		T y;
+		T w;
+		T h : sizeof(T) * 8 - 1;
+		std::make_unsigned_t<T> flipped : 1;
+
+		constexpr basic_compact_rect_xywhf() : x(0), y(0), w(0), h(0), flipped(false) {}
+		constexpr basic_compact_rect_xywhf(const T x_, const T y_, const T w_, const T h_, const bool flipped_) : x(x_), y(y_), w(flipped_ ? h_ : w_), h(flipped_ ? w_ : h_), flipped(flipped_) {}
+		constexpr basic_compact_rect_xywhf(const basic_rect_xywh<T>& b) : basic_compact_rect_xywhf(b.x, b.y, b.w, b.h, false) {}
+
+		constexpr area_type_t<T> area() const { return area_type_t<T>(w) * h; }
+		constexpr area_type_t<T> perimeter() const { return 2 * area_type_t<T>(w) + 2 * area_type_t<T>(h); }
+
+		constexpr auto get_wh() const {
+			return basic_rect_wh<T>(w, h);
+		}
+
+		constexpr auto& get_rect() {
+			return *this;
+		}
+
+		constexpr const auto& get_rect() const {
+			return *this;
+		}
+	};
+
+	/* Whether the rectangle type has a flipped flag, i.e. it is anything but basic_rect_xywh. */
+
+	template <class R>
+	inline constexpr bool is_flippable_rect_v = !std::is_same_v<R, basic_rect_xywh<typename R::coord_type>>;
+
+	/*
+		Computes the area in a type wider than the coordinates,
+		e.g. area_as<std::int64_t>(r) for rectangles bigger than about 46341 x 46341.
+	*/
+
+	template <class A, class R>
+	constexpr A area_as(const R& r) {
+		return static_cast<A>(r.w) * static_cast<A>(r.h);
+	}
+
+	using rect_wh = basic_rect_wh<int>;
+	using rect_xywh = basic_rect_xywh<int>;
+	using rect_xywhf = basic_rect_xywhf<int>;
+
 	using space_rect = rect_xywh;
 }
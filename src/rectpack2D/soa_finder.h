@@ -0,0 +1,275 @@
+#pragma once
+#include <cstddef>
+#include "finders_interface.h"
+
+namespace rectpack2D {
+	/*
+		Structure-of-arrays input and output for the finders,
+		for when the sizes live in separate width and height arrays
+		and the positions have to end up in separate arrays as well, e.g. a GPU upload buffer.
+
+		The arrays are plain pointers with a count, as there is no std::span in C++17.
+		Element types only need to convert to and from the coordinate type of the rectangles,
+		e.g. std::uint16_t sizes will do with int coordinates.
+	*/
+
+	template <class S>
+	struct soa_sizes {
+		const S* widths;
+		const S* heights;
+		std::size_t count;
+	};
+
+	template <class P>
+	struct soa_positions {
+		P* xs;
+		P* ys;
+
+		/* May be null if flipping is disabled or not needed. */
+		bool* flipped;
+	};
+
+	template <class S>
+	auto make_soa_sizes(const S* const widths, const S* const heights, const std::size_t count) {
+		return soa_sizes<S> { widths, heights, count };
+	}
+
+	template <class P>
+	auto make_soa_positions(P* const xs, P* const ys, bool* const flipped = nullptr) {
+		return soa_positions<P> { xs, ys, flipped };
+	}
+
+	/*
+		What the finders see in place of the rectangle at index of the arrays.
+		w and h are read from the sizes, and assigning a placed rectangle
+		writes its position straight to the output arrays, and to x, y and flipped.
+	*/
+
+	template <class empty_spaces_type, class S, class P>
+	class soa_rect {
+		using coord_type = typename empty_spaces_type::coord_type;
+		using rect_type = output_rect_t<empty_spaces_type>;
+
+		const soa_positions<P>* positions = nullptr;
+		std::size_t index = 0;
+
+	public:
+		coord_type x = 0;
+		coord_type y = 0;
+		coord_type w = 0;
+		coord_type h = 0;
+		bool flipped = false;
+
+		soa_rect() = default;
+
+		soa_rect(const soa_sizes<S>& sizes_, const soa_positions<P>& positions_, const std::size_t index_) :
+			positions(&positions_),
+			index(index_),
+			w(static_cast<coord_type>(sizes_.widths[index_])),
+			h(static_cast<coord_type>(sizes_.heights[index_]))
+		{}
+
+		soa_rect& operator=(const rect_type& placed) {
+			x = placed.x;
+			y = placed.y;
+
+			if constexpr(is_flippable_rect_v<rect_type>) {
+				flipped = placed.flipped;
+			}
+
+			positions->xs[index] = static_cast<P>(x);
+			positions->ys[index] = static_cast<P>(y);
+
+			if (positions->flipped) {
+				positions->flipped[index] = flipped;
+			}
+
+			return *this;
+		}
+
+		std::size_t get_index() const {
+			return index;
+		}
+
+		auto get_wh() const {
+			return basic_rect_wh<coord_type>(w, h);
+		}
+
+		auto& get_rect() {
+			return *this;
+		}
+
+		const auto& get_rect() const {
+			return *this;
+		}
+	};
+
+	/* Iterates over an order of indices, presenting each as a soa_rect. */
+
+	template <class empty_spaces_type, class S, class P>
+	class soa_order_iterator {
+		const std::size_t* current;
+		const soa_sizes<S>* sizes;
+		const soa_positions<P>* positions;
+		soa_rect<empty_spaces_type, S, P> dereferenced;
+
+	public:
+		soa_order_iterator(const std::size_t* const current_, const soa_sizes<S>& sizes_, const soa_positions<P>& positions_) :
+			current(current_),
+			sizes(&sizes_),
+			positions(&positions_)
+		{}
+
+		auto& operator*() {
+			dereferenced = soa_rect<empty_spaces_type, S, P>(*sizes, *positions, *current);
+			return dereferenced;
+		}
+
+		auto& operator++() {
+			++current;
+			return *this;
+		}
+
+		bool operator==(const soa_order_iterator& b) const {
+			return current == b.current;
+		}
+
+		bool operator!=(const soa_order_iterator& b) const {
+			return current != b.current;
+		}
+	};
+
+	/*
+		Same as find_best_packing, but reads the sizes from, and writes the positions to, the arrays.
+
+		The orders only hold the indices of the rectangles of non-zero area, sorted by reading the sizes arrays,
+		and the positions are written to the output arrays as each rectangle of the best order is placed -
+		the ones that were not placed are left untouched.
+
+		The callbacks receive a soa_rect, whose get_index tells which rectangle of the arrays it is.
+	*/
+
+	template <class empty_spaces_type, class S, class P, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const finder_scratch<empty_spaces_type> scratch,
+		const soa_sizes<S> sizes,
+		const soa_positions<P> positions,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		using rect_type = output_rect_t<empty_spaces_type>;
+		using coord_type = typename empty_spaces_type::coord_type;
+		using area_type = search_area_t<empty_spaces_type, A>;
+		using iterator_type = soa_order_iterator<empty_spaces_type, S, P>;
+		using order_type = rectpack2D::span<iterator_type>;
+
+		/* The comparators take pointers to rectangles, so they get ones made up from the sizes. */
+
+		const auto by_index = [&sizes](auto predicate) {
+			return [&sizes, predicate](const std::size_t a, const std::size_t b) {
+				rect_type ra;
+				ra.w = static_cast<coord_type>(sizes.widths[a]);
+				ra.h = static_cast<coord_type>(sizes.heights[a]);
+
+				rect_type rb;
+				rb.w = static_cast<coord_type>(sizes.widths[b]);
+				rb.h = static_cast<coord_type>(sizes.heights[b]);
+
+				return predicate(&ra, &rb);
+			};
+		};
+
+		return with_sorted_orders_of<std::size_t>(
+			scratch.orders_memory,
+			input.order_sorting,
+			sizes.count,
+			[&sizes](std::size_t* const valid) {
+				std::size_t count_valid = 0;
+
+				for (std::size_t i = 0; i < sizes.count; ++i) {
+					if (static_cast<area_type>(sizes.widths[i]) * static_cast<area_type>(sizes.heights[i]) != 0) {
+						valid[count_valid++] = i;
+					}
+				}
+
+				return count_valid;
+			},
+			[&](auto for_each_order) {
+				const auto for_each_soa_order = [&](auto callback) {
+					for_each_order([&](const auto& indices) {
+						callback(order_type(
+							iterator_type(indices.begin(), sizes, positions),
+							iterator_type(indices.end(), sizes, positions)
+						));
+					});
+				};
+
+				return find_best_packing_impl<empty_spaces_type, order_type>(
+					scratch.root,
+					for_each_soa_order,
+					input
+				);
+			},
+
+			by_index(comparator),
+			by_index(comparators)...
+		);
+	}
+
+	template <class empty_spaces_type, class S, class P, class F, class G, class A, class Comparator, class... Comparators>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const soa_sizes<S> sizes,
+		const soa_positions<P> positions,
+		const finder_input<F, G, A>& input,
+
+		Comparator comparator,
+		Comparators... comparators
+	) {
+		return find_best_packing<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			sizes,
+			positions,
+			input,
+
+			comparator,
+			comparators...
+		);
+	}
+
+	template <class empty_spaces_type, class S, class P, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const finder_scratch<empty_spaces_type> scratch,
+		const soa_sizes<S> sizes,
+		const soa_positions<P> positions,
+		const finder_input<F, G, A>& input
+	) {
+		return with_default_comparators<empty_spaces_type, search_area_t<empty_spaces_type, A>>(
+			[&](auto... comparators) {
+				return find_best_packing<empty_spaces_type>(
+					scratch,
+					sizes,
+					positions,
+					input,
+
+					comparators...
+				);
+			}
+		);
+	}
+
+	template <class empty_spaces_type, class S, class P, class F, class G, class A>
+	rect_wh_t<empty_spaces_type> find_best_packing(
+		const soa_sizes<S> sizes,
+		const soa_positions<P> positions,
+		const finder_input<F, G, A>& input
+	) {
+		return find_best_packing<empty_spaces_type>(
+			make_finder_scratch(thread_local_root<empty_spaces_type>()),
+			sizes,
+			positions,
+			input
+		);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <utility>
+#include "rect_structs.h"
+
+namespace rectpack2D {
+	/*
+		Policies deciding which empty space a rectangle goes into,
+		passed as the third template argument of empty_spaces.
+
+		last_fit is the original behaviour: the first space that fits, scanning from the most recently created ones.
+
+		The others score every space that fits and take the one with the lowest score.
+		Scanning all spaces is linear in their count on every insertion, whereas last_fit usually stops early,
+		so MaxCandidates bounds the scan to that many spaces past the first one that fits.
+		0 means no bound - all spaces are scanned.
+	*/
+
+	struct last_fit {
+		static constexpr bool first_fit = true;
+	};
+
+	/* Least area left over in the space, then the shorter leftover side. */
+
+	template <int MaxCandidates = 0>
+	struct best_area_fit {
+		static constexpr bool first_fit = false;
+		static constexpr int max_candidates = MaxCandidates;
+
+		template <class T>
+		static constexpr auto score(const basic_rect_xywh<T>& space, const basic_rect_wh<T>& im) {
+			using A = area_type_t<T>;
+
+			const auto leftover_w = A(space.w) - im.w;
+			const auto leftover_h = A(space.h) - im.h;
+
+			return std::make_pair(space.area() - im.area(), std::min(leftover_w, leftover_h));
+		}
+	};
+
+	/* Shortest leftover side, then the longer one. */
+
+	template <int MaxCandidates = 0>
+	struct best_short_side_fit {
+		static constexpr bool first_fit = false;
+		static constexpr int max_candidates = MaxCandidates;
+
+		template <class T>
+		static constexpr auto score(const basic_rect_xywh<T>& space, const basic_rect_wh<T>& im) {
+			using A = area_type_t<T>;
+
+			const auto leftover_w = A(space.w) - im.w;
+			const auto leftover_h = A(space.h) - im.h;
+
+			return std::make_pair(std::min(leftover_w, leftover_h), std::max(leftover_w, leftover_h));
+		}
+	};
+
+	/*
+		The position whose far edge is closest to the y = 0 side of the bin, then the one closest to x = 0.
+		This keeps the packing flush against the origin,
+		which is as close to contact-point placement as free spaces alone can get.
+	*/
+
+	template <int MaxCandidates = 0>
+	struct bottom_left_fit {
+		static constexpr bool first_fit = false;
+		static constexpr int max_candidates = MaxCandidates;
+
+		template <class T>
+		static constexpr auto score(const basic_rect_xywh<T>& space, const basic_rect_wh<T>& im) {
+			using A = area_type_t<T>;
+
+			return std::make_pair(A(space.y) + im.h, A(space.x));
+		}
+	};
+}
@@ -0,0 +1,44 @@
+#include <rectpack2D/auto_tuner.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(tuned_packing_is_valid) {
+	for (const auto count : { 30, 500, 3000 }) {
+		const auto originals = random_rects<rect_xywhf>(count, 1, 60, 100);
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 8192);
+
+		tuned_settings chosen;
+		const auto bin = find_best_packing_tuned<spaces_type>(rects, input, &chosen);
+
+		CHECK(chosen.statistics.count == rects.size());
+		CHECK(counts.unsuccessful == 0);
+		CHECK(valid_packing(originals, rects, bin));
+	}
+}
+
+TEST_CASE(tuning_keeps_flipping_unless_all_square) {
+	auto input = make_finder_input(
+		8192,
+		1,
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		flipping_option::ENABLED
+	);
+
+	std::vector<rect_xywhf> rects = { rect_xywhf(0, 0, 16, 16, false), rect_xywhf(0, 0, 33, 32, false) };
+
+	CHECK(tune_finder_settings(gather_input_statistics<int>(rects), input).flipping_mode == flipping_option::ENABLED);
+
+	rects[1].w = 32;
+
+	CHECK(tune_finder_settings(gather_input_statistics<int>(rects), input).flipping_mode == flipping_option::DISABLED);
+}
@@ -0,0 +1,39 @@
+#include <rectpack2D/batch_finder.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(batch_matches_separate_searches) {
+	std::vector<std::vector<rect_xywhf>> jobs;
+
+	for (unsigned seed = 0; seed < 12; ++seed) {
+		jobs.push_back(random_rects<rect_xywhf>(20 + seed * 10, 1, 50, 50 + seed));
+	}
+
+	auto separately = jobs;
+	const auto batched_originals = jobs;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+
+	batch_settings settings;
+	settings.workers = 3;
+
+	const auto bins = find_best_packing_batch<spaces_type>(jobs, input, settings);
+
+	CHECK(bins.size() == jobs.size());
+	CHECK(counts.unsuccessful == 0);
+
+	for (std::size_t i = 0; i < jobs.size(); ++i) {
+		const auto bin = find_best_packing<spaces_type>(separately[i], input);
+
+		CHECK(bins[i].w == bin.w && bins[i].h == bin.h);
+		CHECK(same_placements(jobs[i], separately[i]));
+		CHECK(valid_packing(batched_originals[i], jobs[i], bins[i]));
+	}
+}
@@ -0,0 +1,46 @@
+#include <sstream>
+#include <rectpack2D/binary_layout.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(binary_layout_round_trip) {
+	auto rects = random_rects<rect_xywhf>(100, 1, 60, 90);
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+
+	const auto bin = find_best_packing<spaces_type>(rects, input);
+	const auto hash = binary_layout_settings_hash(input);
+
+	std::ostringstream out(std::ios::binary);
+	CHECK(write_binary_layout<spaces_type>(out, bin, rects, hash));
+
+	const auto bytes = out.str();
+
+	/* A mapped file is aligned to at least 16 bytes. */
+
+	std::vector<binary_layout_header<rect_xywhf>> aligned(bytes.size() / sizeof(binary_layout_header<rect_xywhf>) + 1);
+	std::memcpy(aligned.data(), bytes.data(), bytes.size());
+
+	const auto view = view_binary_layout<rect_xywhf>(aligned.data(), bytes.size());
+
+	CHECK(view.has_value());
+
+	if (view) {
+		CHECK(view->get_bin().w == bin.w && view->get_bin().h == bin.h);
+		CHECK(view->get_settings_hash() == hash);
+		CHECK(same_placements(std::vector<rect_xywhf>(view->begin(), view->end()), rects));
+	}
+
+	CHECK(!view_binary_layout<rect_xywhf>(aligned.data(), bytes.size() - 1).has_value());
+	CHECK(!view_binary_layout<rect_xywh>(aligned.data(), bytes.size()).has_value());
+
+	auto changed_input = make_counting_input(counts, 2048);
+	CHECK(binary_layout_settings_hash(changed_input) != hash);
+}
@@ -0,0 +1,24 @@
+# Runs rectpack2D-cli on MANIFEST with ARGS, writing to OUTPUT,
+# and fails unless it exits with EXPECTED_RESULT and, if EXPECTED is set, OUTPUT matches it.
+
+execute_process(
+    COMMAND ${CLI} ${ARGS} -o ${OUTPUT} ${MANIFEST}
+    RESULT_VARIABLE result
+    ERROR_VARIABLE errors
+)
+
+if(NOT result EQUAL EXPECTED_RESULT)
+    message(FATAL_ERROR "rectpack2D-cli exited with ${result} instead of ${EXPECTED_RESULT}: ${errors}")
+endif()
+
+if(DEFINED EXPECTED)
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+        RESULT_VARIABLE differs
+    )
+
+    if(differs)
+        file(READ ${OUTPUT} actual)
+        message(FATAL_ERROR "The output of rectpack2D-cli differs from ${EXPECTED}:\n${actual}")
+    endif()
+endif()
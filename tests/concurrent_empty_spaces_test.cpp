@@ -0,0 +1,69 @@
+#include <thread>
+#include <rectpack2D/concurrent_empty_spaces.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = concurrent_empty_spaces<true>;
+}
+
+TEST_CASE(concurrent_insertions_are_valid) {
+	const auto bin = rect_wh(1024, 1024);
+	const auto originals = random_rects<rect_xywhf>(800, 1, 30, 60);
+
+	spaces_type spaces(bin, 4);
+	CHECK(spaces.get_shard_count() == 4);
+
+	std::vector<rect_xywhf> packed = originals;
+	std::vector<char> placed(originals.size(), 0);
+
+	const std::size_t thread_count = 4;
+	std::vector<std::thread> threads;
+
+	for (std::size_t t = 0; t < thread_count; ++t) {
+		threads.emplace_back([&, t]() {
+			for (std::size_t i = t; i < originals.size(); i += thread_count) {
+				if (const auto result = spaces.insert(originals[i].get_wh(), t)) {
+					packed[i] = *result;
+					placed[i] = 1;
+				}
+			}
+		});
+	}
+
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	for (std::size_t i = 0; i < originals.size(); ++i) {
+		CHECK(placed[i] == 1);
+	}
+
+	CHECK(valid_packing(originals, packed, bin));
+
+	const auto aabb = spaces.get_rects_aabb();
+	CHECK(aabb.w <= bin.w && aabb.h <= bin.h);
+}
+
+TEST_CASE(shard_count_is_clamped) {
+	const auto bin = rect_wh(1024, 1024);
+
+	spaces_type none(bin, 0);
+	CHECK(none.get_shard_count() == 1);
+	CHECK(none.insert(rect_wh(1000, 1000), 5).has_value());
+
+	spaces_type too_many(bin, 100);
+	CHECK(too_many.get_shard_count() == spaces_type::max_shards);
+
+	/* Fill every shard from one thread, so that the last insertions have to go through all of them. */
+
+	std::size_t placed = 0;
+
+	for (std::size_t i = 0; i < 2 * spaces_type::max_shards; ++i) {
+		placed += too_many.insert(rect_wh(100, 100), 0).has_value();
+	}
+
+	CHECK(placed == spaces_type::max_shards);
+}
@@ -0,0 +1,65 @@
+#include <rectpack2D/constexpr_finder.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true, static_empty_spaces<256>>;
+}
+
+TEST_CASE(constexpr_finder_is_valid) {
+	const auto originals = random_rects<rect_xywhf>(40, 1, 30, 80);
+
+	std::array<rect_wh, 40> sizes;
+
+	for (std::size_t i = 0; i < sizes.size(); ++i) {
+		sizes[i] = originals[i].get_wh();
+	}
+
+	const auto input = make_finder_input(
+		1000,
+		1,
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		flipping_option::ENABLED
+	);
+
+	const auto packing = find_best_packing_constexpr<spaces_type>(sizes, input);
+	const auto packed = std::vector<rect_xywhf>(packing.rects.begin(), packing.rects.end());
+
+	CHECK(valid_packing(originals, packed, packing.bin));
+
+	auto rects = originals;
+	const auto bin = find_best_packing<spaces_type>(rects, input);
+
+	CHECK(packing.bin.area() <= bin.area() * 11 / 10);
+}
+
+TEST_CASE(constexpr_finder_runs_at_compile_time) {
+	constexpr std::array<rect_wh, 4> sizes = { rect_wh(10, 10), rect_wh(20, 5), rect_wh(5, 20), rect_wh(8, 8) };
+
+	constexpr auto input = make_finder_input(
+		1000,
+		1,
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		[](auto&) { return callback_result::CONTINUE_PACKING; },
+		flipping_option::ENABLED
+	);
+
+	constexpr auto packing = find_best_packing_constexpr<spaces_type>(sizes, input);
+
+	/* 100 + 100 + 100 + 64 units of area can't fit in less than 19 x 19. */
+	static_assert(packing.bin.w * packing.bin.h >= 364);
+	static_assert(packing.bin.w <= 30 && packing.bin.h <= 30);
+	static_assert(packing.rects[1].get_wh().area() == 100);
+
+	std::vector<rect_xywhf> originals;
+
+	for (const auto& s : sizes) {
+		originals.push_back(rect_xywhf(0, 0, s.w, s.h, false));
+	}
+
+	const auto packed = std::vector<rect_xywhf>(packing.rects.begin(), packing.rects.end());
+	CHECK(valid_packing(originals, packed, packing.bin));
+}
@@ -0,0 +1,75 @@
+#include <limits>
+#include <rectpack2D/exact_finder.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(exact_packing_is_valid_and_no_worse) {
+	for (unsigned seed = 0; seed < 6; ++seed) {
+		const auto originals = random_rects<rect_xywhf>(12, 5, 60, 110 + seed);
+
+		auto heuristic = originals;
+		insertion_counts heuristic_counts;
+		auto heuristic_input = make_counting_input(heuristic_counts, 1000);
+		const auto heuristic_bin = find_best_packing<spaces_type>(heuristic, heuristic_input);
+
+		auto rects = originals;
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 1000);
+
+		exact_settings settings;
+		settings.max_nodes = 200000;
+
+		exact_report report;
+		const auto bin = find_best_packing_exact<spaces_type>(rects, input, settings, &report);
+
+		CHECK(counts.successful == rects.size());
+		CHECK(valid_packing(originals, rects, bin));
+		CHECK(bin.area() <= heuristic_bin.area());
+		CHECK(report.improved == (bin.area() < heuristic_bin.area()));
+	}
+}
+
+TEST_CASE(exact_packing_keeps_flips_relative_to_input) {
+	for (unsigned seed = 0; seed < 6; ++seed) {
+		const auto originals = random_rects<rect_xywhf>(12, 5, 60, 120 + seed);
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 1000);
+
+		const auto bin = find_best_packing_exact<spaces_type>(rects, input);
+
+		for (std::size_t i = 0; i < rects.size(); ++i) {
+			const auto& o = originals[i];
+			const auto& r = rects[i];
+
+			CHECK(r.flipped ? (r.w == o.h && r.h == o.w) : (r.w == o.w && r.h == o.h));
+		}
+
+		CHECK(valid_packing(originals, rects, bin));
+	}
+}
+
+TEST_CASE(exact_packing_with_power_of_two_limit_near_overflow) {
+	const auto originals = random_rects<rect_xywhf>(6, 5, 60, 130);
+	auto rects = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input<std::int64_t>(counts, std::numeric_limits<int>::max());
+	input.bin_constraint.rule = bin_size_rule::POWER_OF_TWO;
+
+	exact_settings settings;
+	settings.max_nodes = 20000;
+
+	const auto bin = find_best_packing_exact<spaces_type>(rects, input, settings);
+
+	CHECK(counts.unsuccessful == 0);
+	CHECK(valid_packing(originals, rects, bin));
+	CHECK((bin.w & (bin.w - 1)) == 0 && (bin.h & (bin.h - 1)) == 0);
+}
@@ -0,0 +1,483 @@
+#include <limits>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <type_traits>
+#include <memory_resource>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using flip_spaces = empty_spaces<true>;
+	using no_flip_spaces = empty_spaces<false>;
+
+	/* Packs a copy of rects with find_best_packing, after letting configure adjust the input. */
+
+	template <class spaces_type, class R, class C>
+	auto pack(std::vector<R>& rects, C configure, const int discard_step = 1) {
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 4096, discard_step);
+		configure(input);
+
+		return find_best_packing<spaces_type>(rects, input);
+	}
+
+	template <class spaces_type, class R>
+	auto pack(std::vector<R>& rects) {
+		return pack<spaces_type>(rects, [](auto&) {});
+	}
+}
+
+TEST_CASE(best_packing_is_valid) {
+	for (unsigned seed = 0; seed < 8; ++seed) {
+		const auto originals = random_rects<rect_xywhf>(300, 1, 80, seed);
+
+		auto flipped = originals;
+		CHECK(valid_packing(originals, flipped, pack<flip_spaces>(flipped)));
+
+		const auto originals_xywh = random_rects<rect_xywh>(300, 1, 80, seed);
+		auto unflipped = originals_xywh;
+		CHECK(valid_packing(originals_xywh, unflipped, pack<no_flip_spaces>(unflipped)));
+	}
+}
+
+TEST_CASE(unsuccessful_insertions_are_reported) {
+	auto rects = random_rects<rect_xywhf>(50, 10, 40, 2);
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts, 60);
+
+	find_best_packing<flip_spaces>(rects, input);
+
+	CHECK(counts.unsuccessful > 0);
+}
+
+TEST_CASE(scratch_matches_thread_local_root) {
+	const auto originals = random_rects<rect_xywhf>(200, 1, 60, 3);
+
+	auto with_tls = originals;
+	const auto tls_bin = pack<flip_spaces>(with_tls);
+
+	flip_spaces root({ 0, 0 });
+	std::pmr::monotonic_buffer_resource orders_memory;
+
+	auto with_scratch = originals;
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+
+	const auto scratch_bin = find_best_packing<flip_spaces>(make_finder_scratch(root, &orders_memory), with_scratch, input);
+
+	CHECK(tls_bin.w == scratch_bin.w && tls_bin.h == scratch_bin.h);
+	CHECK(same_placements(with_tls, with_scratch));
+}
+
+TEST_CASE(providers_pack_identically) {
+	const auto originals = random_rects<rect_xywhf>(400, 1, 60, 4);
+
+	auto with_default = originals;
+	auto with_pmr = originals;
+	auto with_static = originals;
+	auto with_small = originals;
+
+	const auto default_bin = pack<flip_spaces>(with_default);
+	const auto pmr_bin = pack<empty_spaces<true, pmr_empty_spaces>>(with_pmr);
+	const auto static_bin = pack<empty_spaces<true, static_empty_spaces<4096>>>(with_static);
+	const auto small_bin = pack<empty_spaces<true, small_empty_spaces<16>>>(with_small);
+
+	CHECK(default_bin.area() == pmr_bin.area());
+	CHECK(default_bin.area() == static_bin.area());
+	CHECK(default_bin.area() == small_bin.area());
+
+	CHECK(same_placements(with_default, with_pmr));
+	CHECK(same_placements(with_default, with_static));
+	CHECK(same_placements(with_default, with_small));
+}
+
+TEST_CASE(narrow_and_wide_coordinates) {
+	using narrow_spaces = empty_spaces<true, basic_default_empty_spaces<std::int16_t>>;
+	using wide_spaces = empty_spaces<true, basic_default_empty_spaces<std::int64_t>>;
+
+	const auto narrow_originals = random_rects<basic_rect_xywhf<std::int16_t>>(200, 1, 60, 5);
+	auto narrow = narrow_originals;
+	CHECK(valid_packing(narrow_originals, narrow, pack<narrow_spaces>(narrow)));
+
+	const auto wide_originals = random_rects<basic_rect_xywhf<std::int64_t>>(200, 1, 60, 5);
+	auto wide = wide_originals;
+	CHECK(valid_packing(wide_originals, wide, pack<wide_spaces>(wide)));
+}
+
+TEST_CASE(compact_rects_pack_identically) {
+	using compact_spaces = empty_spaces<true, basic_default_empty_spaces<std::int16_t>, last_fit, basic_compact_rect_xywhf>;
+	using narrow_spaces = empty_spaces<true, basic_default_empty_spaces<std::int16_t>>;
+
+	static_assert(sizeof(basic_compact_rect_xywhf<std::int16_t>) == sizeof(basic_rect_xywh<std::int16_t>));
+	static_assert(std::is_same_v<output_rect_t<compact_spaces>, basic_compact_rect_xywhf<std::int16_t>>);
+	static_assert(std::is_same_v<decltype(rect_xywhf::flipped), bool>);
+
+	const auto compact_originals = random_rects<basic_compact_rect_xywhf<std::int16_t>>(300, 1, 60, 9);
+	auto compact = compact_originals;
+	const auto compact_bin = pack<compact_spaces>(compact);
+
+	CHECK(valid_packing(compact_originals, compact, compact_bin));
+
+	const auto originals = random_rects<basic_rect_xywhf<std::int16_t>>(300, 1, 60, 9);
+	auto rects = originals;
+	const auto bin = pack<narrow_spaces>(rects);
+
+	CHECK(bin.w == compact_bin.w && bin.h == compact_bin.h);
+
+	for (std::size_t i = 0; i < rects.size(); ++i) {
+		CHECK(rects[i].x == compact[i].x && rects[i].y == compact[i].y);
+		CHECK(rects[i].w == compact[i].w && rects[i].h == compact[i].h);
+		CHECK(rects[i].flipped == bool(compact[i].flipped));
+	}
+}
+
+TEST_CASE(areas_are_computed_wide) {
+	static_assert(std::is_same_v<area_type_t<std::int16_t>, int>);
+	static_assert(std::is_same_v<area_type_t<int>, std::int64_t>);
+	static_assert(std::is_same_v<area_type_t<std::int64_t>, std::int64_t>);
+
+	static_assert(std::is_same_v<search_area_t<empty_spaces<true>>, int>);
+
+	const auto r = rect_xywhf(0, 0, 100000, 100000, false);
+	CHECK(r.area() == std::int64_t(10000000000));
+}
+
+TEST_CASE(wide_area_type_packs_big_bins) {
+	const auto originals = random_rects<rect_xywhf>(64, 9000, 12000, 6);
+	auto rects = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input<std::int64_t>(counts, 120000);
+
+	const auto bin = find_best_packing<flip_spaces>(rects, input);
+
+	CHECK(counts.unsuccessful == 0);
+	CHECK(valid_packing(originals, rects, bin));
+}
+
+TEST_CASE(power_of_two_and_multiple_of_bins) {
+	const auto originals = random_rects<rect_xywhf>(150, 3, 70, 7);
+
+	auto power_of_two = originals;
+	const auto power_of_two_bin = pack<flip_spaces>(power_of_two, [](auto& input) {
+		input.bin_constraint.rule = bin_size_rule::POWER_OF_TWO;
+	});
+
+	CHECK(valid_packing(originals, power_of_two, power_of_two_bin));
+	CHECK((power_of_two_bin.w & (power_of_two_bin.w - 1)) == 0);
+	CHECK((power_of_two_bin.h & (power_of_two_bin.h - 1)) == 0);
+
+	auto blocks = originals;
+	const auto blocks_bin = pack<flip_spaces>(blocks, [](auto& input) {
+		input.bin_constraint.rule = bin_size_rule::MULTIPLE_OF;
+		input.bin_constraint.multiple = 4;
+		input.bin_constraint.rect_alignment = 4;
+	});
+
+	CHECK(valid_packing(originals, blocks, blocks_bin));
+	CHECK(blocks_bin.w % 4 == 0 && blocks_bin.h % 4 == 0);
+
+	for (const auto& r : blocks) {
+		CHECK(r.x % 4 == 0 && r.y % 4 == 0);
+	}
+}
+
+TEST_CASE(selection_policies_are_valid) {
+	const auto originals = random_rects<rect_xywhf>(300, 1, 60, 8);
+
+	auto best_area = originals;
+	CHECK(valid_packing(originals, best_area, pack<empty_spaces<true, default_empty_spaces, best_area_fit<64>>>(best_area)));
+
+	auto best_short_side = originals;
+	CHECK(valid_packing(originals, best_short_side, pack<empty_spaces<true, default_empty_spaces, best_short_side_fit<64>>>(best_short_side)));
+
+	auto bottom_left = originals;
+	CHECK(valid_packing(originals, bottom_left, pack<empty_spaces<true, default_empty_spaces, bottom_left_fit<64>>>(bottom_left)));
+}
+
+TEST_CASE(pruning_and_merging_are_valid) {
+	for (unsigned seed = 0; seed < 4; ++seed) {
+		const auto originals = random_rects<rect_xywhf>(300, 1, 60, 10 + seed);
+
+		auto pruned = originals;
+		const auto pruned_bin = pack<flip_spaces>(pruned, [](auto& input) {
+			input.space_pruning = space_pruning_option::ENABLED;
+		});
+
+		CHECK(valid_packing(originals, pruned, pruned_bin));
+
+		auto merged = originals;
+		const auto merged_bin = pack<flip_spaces>(merged, [](auto& input) {
+			input.space_merging = space_merging_option::AMORTIZED;
+		});
+
+		CHECK(valid_packing(originals, merged, merged_bin));
+	}
+}
+
+namespace {
+	/* A provider that can't modify its spaces in place, for which pruning does nothing. */
+
+	class read_only_empty_spaces {
+		basic_default_empty_spaces<int> spaces;
+
+	public:
+		using coord_type = int;
+
+		void remove(const int i) { spaces.remove(i); }
+		bool add(const basic_rect_xywh<int> r) { return spaces.add(r); }
+		auto get_count() const { return spaces.get_count(); }
+		void reset() { spaces.reset(); }
+		const auto& get(const int i) const { return spaces.get(i); }
+	};
+
+	template <class spaces_type, class R>
+	void check_pruning_keeps_placements(const std::vector<R>& originals) {
+		auto unpruned = originals;
+		const auto unpruned_bin = pack<spaces_type>(unpruned);
+
+		auto pruned = originals;
+		const auto pruned_bin = pack<spaces_type>(pruned, [](auto& input) {
+			input.space_pruning = space_pruning_option::ENABLED;
+		});
+
+		CHECK(unpruned_bin.w == pruned_bin.w && unpruned_bin.h == pruned_bin.h);
+		CHECK(same_placements(unpruned, pruned));
+	}
+}
+
+TEST_CASE(pruning_keeps_placements) {
+	static_assert(has_mutable_spaces<default_empty_spaces>::value);
+	static_assert(has_mutable_spaces<static_empty_spaces<16>>::value);
+	static_assert(!has_mutable_spaces<read_only_empty_spaces>::value);
+
+	for (unsigned seed = 0; seed < 3; ++seed) {
+		/* Big minimum sides leave plenty of slivers that no rectangle fits into. */
+
+		const auto originals = random_rects<rect_xywhf>(500, 20, 60, 40 + seed);
+		const auto narrow_originals = random_rects<basic_rect_xywhf<std::int16_t>>(500, 20, 60, 40 + seed);
+
+		check_pruning_keeps_placements<flip_spaces>(originals);
+		check_pruning_keeps_placements<no_flip_spaces>(random_rects<rect_xywh>(500, 20, 60, 40 + seed));
+		check_pruning_keeps_placements<empty_spaces<true, small_empty_spaces<16>>>(originals);
+		check_pruning_keeps_placements<empty_spaces<true, default_empty_spaces, best_area_fit<8>>>(originals);
+		check_pruning_keeps_placements<empty_spaces<true, default_empty_spaces, best_short_side_fit<0>>>(originals);
+		check_pruning_keeps_placements<empty_spaces<true, default_empty_spaces, bottom_left_fit<64>>>(originals);
+		check_pruning_keeps_placements<empty_spaces<true, read_only_empty_spaces>>(originals);
+		check_pruning_keeps_placements<empty_spaces<true, basic_default_empty_spaces<std::int16_t>>>(narrow_originals);
+	}
+}
+
+TEST_CASE(merging_keeps_the_free_area) {
+	flip_spaces root(rect_wh(1024, 1024));
+
+	for (const auto& r : random_rects<rect_xywhf>(400, 1, 40, 80)) {
+		root.insert(r.get_wh());
+	}
+
+	const auto free_area = [&root]() {
+		std::int64_t area = 0;
+
+		for (int i = 0; i < static_cast<int>(root.get_spaces().get_count()); ++i) {
+			area += root.get_spaces().get(i).area();
+		}
+
+		return area;
+	};
+
+	const auto area_before = free_area();
+	const auto count_before = root.get_spaces().get_count();
+
+	root.merge_spaces();
+
+	CHECK(free_area() == area_before);
+	CHECK(root.get_spaces().get_count() < count_before);
+
+	const auto& spaces = root.get_spaces();
+
+	for (int i = 0; i < static_cast<int>(spaces.get_count()); ++i) {
+		for (int j = 0; j < static_cast<int>(spaces.get_count()); ++j) {
+			const auto& a = spaces.get(i);
+			const auto& b = spaces.get(j);
+
+			CHECK(!(a.x == b.x && a.w == b.w && a.y + a.h == b.y));
+			CHECK(!(a.y == b.y && a.h == b.h && a.x + a.w == b.x));
+		}
+	}
+}
+
+TEST_CASE(incumbent_bound_keeps_placements) {
+	for (unsigned seed = 0; seed < 4; ++seed) {
+		const auto originals = random_rects<rect_xywhf>(300, 1, 60, 20 + seed);
+
+		for (const auto discard_step : { 1, -4, 16 }) {
+			search_stats bounded_stats;
+			search_stats full_stats;
+
+			auto bounded = originals;
+			const auto bounded_bin = pack<flip_spaces>(bounded, [&](auto& input) {
+				input.stats = &bounded_stats;
+			}, discard_step);
+
+			auto full = originals;
+			const auto full_bin = pack<flip_spaces>(full, [&](auto& input) {
+				input.stats = &full_stats;
+				input.incumbent_bound = incumbent_bound_option::DISABLED;
+			}, discard_step);
+
+			CHECK(bounded_bin.w == full_bin.w && bounded_bin.h == full_bin.h);
+			CHECK(same_placements(bounded, full));
+			CHECK(bounded_stats.trials <= full_stats.trials);
+		}
+	}
+}
+
+TEST_CASE(pipelined_sorting_matches_serial) {
+	for (const auto count : { 10, 3000 }) {
+		const auto originals = random_rects<rect_xywhf>(count, 1, 60, 30);
+
+		auto serial = originals;
+		const auto serial_bin = pack<flip_spaces>(serial);
+
+		auto pipelined = originals;
+		const auto pipelined_bin = pack<flip_spaces>(pipelined, [](auto& input) {
+			input.order_sorting = order_sorting_option::PIPELINED;
+		});
+
+		CHECK(serial_bin.w == pipelined_bin.w && serial_bin.h == pipelined_bin.h);
+		CHECK(same_placements(serial, pipelined));
+	}
+}
+
+TEST_CASE(stats_count_the_trials) {
+	auto rects = random_rects<rect_xywhf>(100, 1, 60, 31);
+
+	search_stats stats;
+
+	pack<flip_spaces>(rects, [&stats](auto& input) {
+		input.stats = &stats;
+	});
+
+	CHECK(stats.trials > 0);
+}
+
+TEST_CASE(dont_sort_is_valid) {
+	const auto originals = random_rects<rect_xywhf>(100, 1, 60, 32);
+	auto rects = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+
+	CHECK(valid_packing(originals, rects, find_best_packing_dont_sort<flip_spaces>(rects, input)));
+}
+
+TEST_CASE(fixed_bin_is_valid) {
+	const auto originals = random_rects<rect_xywhf>(200, 1, 40, 33);
+
+	for (const auto criterion_rects : { false, true }) {
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts);
+
+		const auto bin = rect_wh(1024, 1024);
+
+		if (criterion_rects) {
+			find_packing_in_bin<flip_spaces, fixed_bin_criterion::MOST_RECTS>(rects, bin, input);
+		}
+		else {
+			find_packing_in_bin<flip_spaces>(rects, bin, input);
+		}
+
+		CHECK(counts.unsuccessful == 0);
+		CHECK(valid_packing(originals, rects, bin));
+	}
+}
+
+TEST_CASE(fixed_bin_returns_the_used_area) {
+	std::vector<rect_xywhf> rects = { rect_xywhf(0, 0, 10, 10, false), rect_xywhf(0, 0, 20, 5, false) };
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts, 4096, 1, flipping_option::DISABLED);
+
+	const auto used = find_packing_in_bin<flip_spaces>(rects, rect_wh(512, 512), input);
+
+	CHECK(counts.successful == 2);
+	CHECK(used.w == 30 && used.h == 10);
+}
+
+TEST_CASE(aspect_sweep_is_valid) {
+	const auto originals = random_rects<rect_xywhf>(200, 1, 60, 34);
+
+	for (const auto objective : { bin_objective::MIN_AREA, bin_objective::MIN_MAX_SIDE }) {
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts);
+
+		aspect_sweep_settings settings;
+		settings.objective = objective;
+
+		const auto bin = find_best_packing_aspect_sweep<flip_spaces>(rects, input, settings);
+
+		CHECK(counts.unsuccessful == 0);
+		CHECK(valid_packing(originals, rects, bin));
+		CHECK(bin.w <= 4096 && bin.h <= 4096);
+	}
+}
+
+TEST_CASE(aspect_sweep_on_a_pool_matches_sequential) {
+	const auto originals = random_rects<rect_xywhf>(300, 1, 60, 35);
+
+	auto sequential = originals;
+	search_stats sequential_stats;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+	input.stats = &sequential_stats;
+
+	const auto sequential_bin = find_best_packing_aspect_sweep<flip_spaces>(sequential, input);
+
+	/* Runs the odd tasks on another thread, and the even ones on the calling thread. */
+
+	aspect_sweep_settings settings;
+
+	settings.parallel_for = [](const std::size_t count, const std::function<void(std::size_t)>& task) {
+		std::thread other([&]() {
+			for (std::size_t i = 1; i < count; i += 2) {
+				task(i);
+			}
+		});
+
+		for (std::size_t i = 0; i < count; i += 2) {
+			task(i);
+		}
+
+		other.join();
+	};
+
+	auto pooled = originals;
+	search_stats pooled_stats;
+	input.stats = &pooled_stats;
+
+	const auto pooled_bin = find_best_packing_aspect_sweep<flip_spaces>(pooled, input, settings);
+
+	CHECK(sequential_bin.w == pooled_bin.w && sequential_bin.h == pooled_bin.h);
+	CHECK(same_placements(sequential, pooled));
+	CHECK(sequential_stats.trials == pooled_stats.trials);
+}
+
+TEST_CASE(power_of_two_indices_of_huge_sides) {
+	bin_size_constraint constraint;
+	constraint.rule = bin_size_rule::POWER_OF_TWO;
+
+	CHECK(constraint.index_of(1) == 0);
+	CHECK(constraint.index_of(3) == 1);
+	CHECK(constraint.index_of(1 << 30) == 30);
+	CHECK(constraint.index_of(std::numeric_limits<int>::max()) == 30);
+	CHECK(constraint.side_of(constraint.index_of(std::numeric_limits<int>::max())) == (1 << 30));
+}
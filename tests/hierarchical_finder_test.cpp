@@ -0,0 +1,115 @@
+#include <memory_resource>
+#include <rectpack2D/hierarchical_finder.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(hierarchical_packing_is_valid) {
+	const auto originals = random_rects<rect_xywhf>(3000, 1, 40, 40);
+
+	for (const auto parallel : { false, true }) {
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 8192);
+
+		hierarchical_settings settings;
+		settings.max_tile_rects = 500;
+		settings.parallel = parallel;
+
+		const auto bin = find_best_packing_hierarchical<spaces_type>(rects, input, settings);
+
+		CHECK(counts.successful == rects.size());
+		CHECK(counts.unsuccessful == 0);
+		CHECK(valid_packing(originals, rects, bin));
+	}
+}
+
+TEST_CASE(hierarchical_packing_by_size_class_is_valid) {
+	auto originals = random_rects<rect_xywhf>(1000, 1, 20, 41);
+	const auto big = random_rects<rect_xywhf>(50, 60, 200, 42);
+	originals.insert(originals.end(), big.begin(), big.end());
+
+	auto rects = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts, 8192);
+
+	hierarchical_settings settings;
+	settings.max_tile_rects = 200;
+
+	const auto bin = find_best_packing_hierarchical<spaces_type>(rects, input, settings, cluster_by_size_class());
+
+	CHECK(counts.successful == rects.size());
+	CHECK(valid_packing(originals, rects, bin));
+}
+
+TEST_CASE(hierarchical_scratch_matches_thread_local_root) {
+	const auto originals = random_rects<rect_xywhf>(2000, 1, 40, 43);
+
+	auto with_scratch = originals;
+	auto with_tls = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts, 8192);
+
+	hierarchical_settings settings;
+	settings.max_tile_rects = 300;
+
+	spaces_type root { rect_wh() };
+	std::pmr::unsynchronized_pool_resource orders_memory;
+
+	const auto scratch_bin = find_best_packing_hierarchical<spaces_type>(make_finder_scratch(root, &orders_memory), with_scratch, input, settings);
+	const auto tls_bin = find_best_packing_hierarchical<spaces_type>(with_tls, input, settings);
+
+	CHECK(scratch_bin.w == tls_bin.w && scratch_bin.h == tls_bin.h);
+	CHECK(same_placements(with_scratch, with_tls));
+}
+
+TEST_CASE(hierarchical_reports_zero_area_rects) {
+	auto originals = random_rects<rect_xywhf>(500, 1, 40, 44);
+	originals.push_back(rect_xywhf(5, 5, 0, 10, false));
+	originals.push_back(rect_xywhf(5, 5, 10, 0, false));
+
+	auto rects = originals;
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts, 8192);
+
+	hierarchical_settings settings;
+	settings.max_tile_rects = 100;
+
+	const auto bin = find_best_packing_hierarchical<spaces_type>(rects, input, settings);
+
+	CHECK(counts.successful == rects.size());
+	CHECK(rects[rects.size() - 1].x == 0 && rects[rects.size() - 1].y == 0);
+	CHECK(valid_packing(originals, rects, bin));
+}
+
+TEST_CASE(hierarchical_fallback_is_valid) {
+	/* A cluster per width makes too many strips to stack within max_bin_side, so the flat search takes over. */
+
+	const auto originals = random_rects<rect_xywhf>(1000, 1, 40, 45);
+	const auto cluster_by_width = [](const rect_xywhf& r) { return static_cast<std::size_t>(r.w); };
+
+	for (const auto parallel : { false, true }) {
+		auto rects = originals;
+
+		insertion_counts counts;
+		auto input = make_counting_input(counts, 700);
+
+		hierarchical_settings settings;
+		settings.parallel = parallel;
+
+		const auto bin = find_best_packing_hierarchical<spaces_type>(rects, input, settings, cluster_by_width);
+
+		CHECK(counts.successful == rects.size());
+		CHECK(counts.unsuccessful == 0);
+		CHECK(valid_packing(originals, rects, bin));
+	}
+}
@@ -0,0 +1,32 @@
+#include <cstring>
+#include "test_utils.h"
+
+/* Runs every test, or only those whose names contain the first argument. */
+
+int main(const int argc, char** const argv) {
+	using namespace rectpack2D_tests;
+
+	const char* const filter = argc > 1 ? argv[1] : "";
+	int failed_tests = 0;
+	int run_tests = 0;
+
+	for (const auto& t : all_tests()) {
+		if (std::strstr(t.name, filter) == nullptr) {
+			continue;
+		}
+
+		const auto failed_before = failed_checks();
+
+		t.run();
+		++run_tests;
+
+		if (failed_checks() != failed_before) {
+			++failed_tests;
+			std::cerr << "FAILED: " << t.name << std::endl;
+		}
+	}
+
+	std::cout << run_tests - failed_tests << " of " << run_tests << " tests passed." << std::endl;
+
+	return failed_tests == 0 && run_tests > 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <utility>
+#include <rectpack2D/soa_finder.h>
+#include "test_utils.h"
+
+using namespace rectpack2D;
+using namespace rectpack2D_tests;
+
+namespace {
+	using spaces_type = empty_spaces<true>;
+}
+
+TEST_CASE(soa_matches_array_of_structures) {
+	const auto originals = random_rects<rect_xywhf>(300, 1, 60, 70);
+
+	std::vector<std::uint16_t> widths;
+	std::vector<std::uint16_t> heights;
+
+	for (const auto& r : originals) {
+		widths.push_back(static_cast<std::uint16_t>(r.w));
+		heights.push_back(static_cast<std::uint16_t>(r.h));
+	}
+
+	std::vector<int> xs(originals.size(), -1);
+	std::vector<int> ys(originals.size(), -1);
+	bool flipped[300] = {};
+
+	insertion_counts counts;
+	auto input = make_counting_input(counts);
+
+	const auto soa_bin = find_best_packing<spaces_type>(
+		make_soa_sizes(widths.data(), heights.data(), widths.size()),
+		make_soa_positions(xs.data(), ys.data(), flipped),
+		input
+	);
+
+	CHECK(counts.successful == originals.size());
+
+	auto rects = originals;
+	const auto bin = find_best_packing<spaces_type>(rects, input);
+
+	CHECK(soa_bin.w == bin.w && soa_bin.h == bin.h);
+
+	auto from_soa = originals;
+
+	for (std::size_t i = 0; i < originals.size(); ++i) {
+		auto& r = from_soa[i];
+
+		r.x = xs[i];
+		r.y = ys[i];
+		r.flipped = flipped[i];
+
+		if (r.flipped) {
+			std::swap(r.w, r.h);
+		}
+	}
+
+	CHECK(same_placements(from_soa, rects));
+	CHECK(valid_packing(originals, from_soa, soa_bin));
+}
+
+TEST_CASE(soa_writes_only_the_placed_rects) {
+	const std::uint16_t widths[] = { 10, 0, 20, 600, 5 };
+	const std::uint16_t heights[] = { 10, 7, 5, 600, 5 };
+	const std::size_t count = 5;
+
+	std::vector<int> xs(count, -1);
+	std::vector<int> ys(count, -1);
+	std::vector<char> reported(count, 0);
+
+	const auto input = make_finder_input(
+		512,
+		1,
+		[&](auto& r) { reported[r.get_index()] = 1; CHECK(xs[r.get_index()] == r.x); return callback_result::CONTINUE_PACKING; },
+		[&](auto& r) { reported[r.get_index()] = 2; return callback_result::CONTINUE_PACKING; },
+		flipping_option::ENABLED
+	);
+
+	find_best_packing<spaces_type>(
+		make_soa_sizes(widths, heights, count),
+		make_soa_positions(xs.data(), ys.data()),
+		input
+	);
+
+	CHECK(reported[0] == 1 && reported[2] == 1 && reported[4] == 1);
+	CHECK(reported[1] == 0 && xs[1] == -1);
+	CHECK(reported[3] == 2 && xs[3] == -1 && ys[3] == -1);
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <atomic>
+#include <iostream>
+#include <rectpack2D/finders_interface.h>
+
+/*
+	A minimal test harness, so that the tests need nothing but the library itself.
+
+	TEST_CASE(name) { ... } defines a test that main.cpp runs,
+	and CHECK(condition) reports the failed condition without stopping the test.
+*/
+
+namespace rectpack2D_tests {
+	struct test_case {
+		const char* name;
+		void (*run)();
+	};
+
+	inline std::vector<test_case>& all_tests() {
+		static std::vector<test_case> tests;
+		return tests;
+	}
+
+	inline int& failed_checks() {
+		static int count = 0;
+		return count;
+	}
+
+	struct test_registration {
+		test_registration(const char* const name, void (*run)()) {
+			all_tests().push_back({ name, run });
+		}
+	};
+
+	inline bool check(const bool condition, const char* const expression, const char* const file, const int line) {
+		if (!condition) {
+			++failed_checks();
+			std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+		}
+
+		return condition;
+	}
+
+	template <class R>
+	bool is_flipped(const R& r) {
+		if constexpr(rectpack2D::is_flippable_rect_v<R>) {
+			return r.flipped;
+		}
+		else {
+			(void)r;
+			return false;
+		}
+	}
+
+	/* Sides drawn uniformly from [min_side, max_side], each rectangle at the origin and not flipped. */
+
+	template <class R>
+	std::vector<R> random_rects(const std::size_t count, const int min_side, const int max_side, const unsigned seed) {
+		using coord_type = typename R::coord_type;
+
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> side(min_side, max_side);
+
+		std::vector<R> rects;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			R r;
+			r.w = static_cast<coord_type>(side(rng));
+			r.h = static_cast<coord_type>(side(rng));
+
+			rects.push_back(r);
+		}
+
+		return rects;
+	}
+
+	/*
+		Whether every rectangle of packed with a non-zero area lies within the bin,
+		kept the size of its counterpart in originals (swapped if flipped),
+		and overlaps no other one.
+	*/
+
+	template <class R, class B>
+	bool valid_packing(const std::vector<R>& originals, const std::vector<R>& packed, const B& bin) {
+		using area_type = long long;
+
+		if (originals.size() != packed.size()) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i < packed.size(); ++i) {
+			const auto& o = originals[i];
+			const auto& p = packed[i];
+
+			const bool same_size = is_flipped(p)
+				? (p.w == o.h && p.h == o.w)
+				: (p.w == o.w && p.h == o.h)
+			;
+
+			if (!same_size) {
+				return false;
+			}
+
+			if (area_type(p.w) * p.h == 0) {
+				continue;
+			}
+
+			if (p.x < 0 || p.y < 0 || area_type(p.x) + p.w > bin.w || area_type(p.y) + p.h > bin.h) {
+				return false;
+			}
+		}
+
+		for (std::size_t i = 0; i < packed.size(); ++i) {
+			const auto& a = packed[i];
+
+			if (area_type(a.w) * a.h == 0) {
+				continue;
+			}
+
+			for (std::size_t j = i + 1; j < packed.size(); ++j) {
+				const auto& b = packed[j];
+
+				if (area_type(b.w) * b.h == 0) {
+					continue;
+				}
+
+				const bool disjoint =
+					area_type(a.x) + a.w <= b.x || area_type(b.x) + b.w <= a.x ||
+					area_type(a.y) + a.h <= b.y || area_type(b.y) + b.h <= a.y
+				;
+
+				if (!disjoint) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	template <class R>
+	bool same_placements(const std::vector<R>& a, const std::vector<R>& b) {
+		if (a.size() != b.size()) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i < a.size(); ++i) {
+			if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].w != b[i].w || a[i].h != b[i].h || is_flipped(a[i]) != is_flipped(b[i])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/* Callbacks that count the insertions and never abort - from any number of threads at once. */
+
+	struct insertion_counts {
+		std::atomic<std::size_t> successful = 0;
+		std::atomic<std::size_t> unsuccessful = 0;
+	};
+
+	template <class A = void>
+	auto make_counting_input(
+		insertion_counts& counts,
+		const int max_bin_side = 4096,
+		const int discard_step = 1,
+		const rectpack2D::flipping_option flipping_mode = rectpack2D::flipping_option::ENABLED
+	) {
+		using namespace rectpack2D;
+
+		return make_finder_input<A>(
+			max_bin_side,
+			discard_step,
+			[&counts](auto&) { ++counts.successful; return callback_result::CONTINUE_PACKING; },
+			[&counts](auto&) { ++counts.unsuccessful; return callback_result::CONTINUE_PACKING; },
+			flipping_mode
+		);
+	}
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const rectpack2D_tests::test_registration name##_registration(#name, name); \
+	static void name()
+
+#define CHECK(...) rectpack2D_tests::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)